@@ -0,0 +1,141 @@
+// checkpoint.cpp
+// Periodic on-disk snapshots of the shared marking state for --resume
+
+#include "checkpoint.h"
+#include "semaphore_manager.h"
+#include "file_manager.h"
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+
+const std::string Checkpoint::CHECKPOINT_FILENAME = "data/checkpoint.bin";
+const int Checkpoint::INTERVAL_MS = 1000;
+
+CheckpointData Checkpoint::last_saved;
+bool Checkpoint::have_last_saved = false;
+
+static const char CHECKPOINT_MAGIC[4] = {'C', 'K', 'P', 'T'};
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+bool Checkpoint::save(SharedMemory* shm, SemaphoreManager* sem) {
+    CheckpointData snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    memcpy(snapshot.magic, CHECKPOINT_MAGIC, sizeof(snapshot.magic));
+    snapshot.version = CHECKPOINT_VERSION;
+    
+    // Copying ~600 bytes under the locks is far cheaper than the file write
+    if (sem != nullptr) {
+        sem->lock_exam_slot();
+        sem->start_read_rubric();
+    }
+    
+    ExamData* exam = shm->get_exam_data();
+    snapshot.student_number = exam->student_number;
+    snapshot.current_exam_index = exam->current_exam_index;
+    snapshot.all_marked = exam->all_marked;
+    for (int i = 0; i < 5; i++) {
+        snapshot.questions_marked[i] = exam->questions_marked[i];
+    }
+    memcpy(snapshot.rubric_text, shm->get_rubric_data()->rubric_text, sizeof(snapshot.rubric_text));
+    
+    if (sem != nullptr) {
+        sem->end_read_rubric();
+        sem->unlock_exam_slot();
+    }
+    
+    // Nothing changed since the last checkpoint, skip the write
+    if (have_last_saved && memcmp(&snapshot, &last_saved, sizeof(snapshot)) == 0) {
+        return true;
+    }
+    
+    // Write a temporary file and rename it so a crash never leaves a torn checkpoint
+    std::string temp_filename = CHECKPOINT_FILENAME + ".tmp";
+    std::ofstream file(temp_filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not write checkpoint: " << temp_filename << std::endl;
+        return false;
+    }
+    file.write((const char*)&snapshot, sizeof(snapshot));
+    file.close();
+    
+    if (!file || rename(temp_filename.c_str(), CHECKPOINT_FILENAME.c_str()) != 0) {
+        std::cerr << "Error: Could not write checkpoint: " << CHECKPOINT_FILENAME << std::endl;
+        return false;
+    }
+    
+    memcpy(&last_saved, &snapshot, sizeof(last_saved));
+    have_last_saved = true;
+    return true;
+}
+
+bool Checkpoint::load(CheckpointData& saved) {
+    std::ifstream file(CHECKPOINT_FILENAME, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: No checkpoint found at " << CHECKPOINT_FILENAME << std::endl;
+        return false;
+    }
+    
+    file.read((char*)&saved, sizeof(saved));
+    if (!file || memcmp(saved.magic, CHECKPOINT_MAGIC, sizeof(saved.magic)) != 0 ||
+        saved.version != CHECKPOINT_VERSION) {
+        std::cerr << "Error: Invalid checkpoint file: " << CHECKPOINT_FILENAME << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::restore(const CheckpointData& saved, SharedMemory* shm) {
+    // The exam list may have changed since the checkpoint, find the exam by student number
+    int64_t index = saved.current_exam_index;
+    int64_t count = shm->get_exam_count();
+    if (index < 0 || index >= count || shm->get_exam_entry(index)->student_number != saved.student_number) {
+        index = -1;
+        for (int64_t i = 0; i < count; i++) {
+            if (shm->get_exam_entry(i)->student_number == saved.student_number) {
+                index = i;
+                break;
+            }
+        }
+    }
+    if (index == -1) {
+        std::cerr << "Error: Checkpointed student " << saved.student_number
+                  << " is no longer in the exam list" << std::endl;
+        return false;
+    }
+    
+    if (!shm->load_exam_from_file(saved.student_number, (int)index)) {
+        return false;
+    }
+    
+    ExamData* exam = shm->get_exam_data();
+    int already_marked = 0;
+    for (int i = 0; i < 5; i++) {
+        exam->questions_marked[i] = saved.questions_marked[i];
+        if (saved.questions_marked[i]) {
+            already_marked++;
+        }
+    }
+    exam->all_marked = saved.all_marked || already_marked == 5;
+    
+    // The rubric file was loaded at startup and wins: it holds corrections
+    // saved after this snapshot and edits made while the run was down
+    RubricData* rubric = shm->get_rubric_data();
+    bool rubric_changed = false;
+    for (int i = 0; i < 5; i++) {
+        rubric_changed = rubric_changed || strcmp(rubric->rubric_text[i], saved.rubric_text[i]) != 0;
+    }
+    if (rubric_changed) {
+        std::cout << "[CHECKPOINT] " << FileManager::RUBRIC_FILENAME
+                  << " changed since the checkpoint, keeping the file's rubric" << std::endl;
+    }
+    
+    std::cout << "[CHECKPOINT] Resuming student " << saved.student_number << " with "
+              << already_marked << " of 5 questions already marked" << std::endl;
+    return true;
+}
+
+void Checkpoint::remove() {
+    std::remove(CHECKPOINT_FILENAME.c_str());
+    have_last_saved = false;
+}
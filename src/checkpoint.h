@@ -0,0 +1,47 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "shared_memory.h"
+#include <cstdint>
+#include <string>
+
+class SemaphoreManager;
+
+// Snapshot of the marking state written to disk while TAs run
+struct CheckpointData {
+    char magic[4];
+    uint32_t version;
+    int64_t student_number;
+    int32_t current_exam_index;
+    bool questions_marked[5];
+    bool all_marked;
+    char rubric_text[5][100];
+};
+
+class Checkpoint {
+private:
+    static CheckpointData last_saved;
+    static bool have_last_saved;
+    
+public:
+    static const std::string CHECKPOINT_FILENAME;
+    static const int INTERVAL_MS;
+    
+    // Snapshot shared memory and write it if anything changed since the last
+    // save. sem is nullptr for Part A, otherwise the exam and rubric locks are
+    // held while copying so the snapshot is consistent.
+    static bool save(SharedMemory* shm, SemaphoreManager* sem);
+    
+    // Read the last checkpoint from disk
+    static bool load(CheckpointData& saved);
+    
+    // Put a loaded checkpoint back into shared memory; questions that were
+    // being marked when it was taken are marked again. The rubric already
+    // loaded from the file is kept, the snapshot's copy is only compared.
+    static bool restore(const CheckpointData& saved, SharedMemory* shm);
+    
+    // Remove the checkpoint after a run completes
+    static void remove();
+};
+
+#endif
@@ -0,0 +1,376 @@
+// coordinator.cpp
+// Hands out (exam, question) leases to socket-connected TA workers
+
+#include "coordinator.h"
+#include "file_manager.h"
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+volatile sig_atomic_t Coordinator::stop_requested = 0;
+
+Coordinator::Coordinator(const std::string& ep, int idle_timeout)
+    : endpoint(ep), listen_fd(-1), total_items(0), completed_items(0),
+      idle_timeout_seconds(idle_timeout) {
+    memset(&rubric, 0, sizeof(rubric));
+}
+
+void Coordinator::request_stop(int) {
+    stop_requested = 1;
+}
+
+Coordinator::~Coordinator() {
+    cleanup();
+}
+
+bool Coordinator::initialize() {
+    if (!FileManager::read_rubric_file(rubric.rubric_text)) {
+        std::cerr << "[COORD] Error: Failed to load rubric" << std::endl;
+        return false;
+    }
+
+    std::vector<int64_t> exam_list = FileManager::get_exam_list();
+    if (exam_list.empty()) {
+        std::cerr << "[COORD] Error: No exam files found in " << FileManager::EXAM_DIR << std::endl;
+        return false;
+    }
+
+    // Every question of every exam up to the termination exam is one work item
+    for (size_t i = 0; i < exam_list.size(); i++) {
+        int64_t student_num;
+        if (!FileManager::read_exam_file(exam_list[i], student_num)) {
+            std::cerr << "[COORD] Skipping unreadable exam " << exam_list[i] << std::endl;
+            continue;
+        }
+        if (FileManager::is_termination_exam(student_num)) {
+            break;
+        }
+
+        ExamProgress& exam = progress[student_num];
+        exam.remaining = 5;
+        for (int q = 0; q < 5; q++) {
+            exam.done[q] = false;
+            WorkItem item;
+            item.student_number = student_num;
+            item.question = (uint8_t)q;
+            pending.push_back(item);
+        }
+    }
+    total_items = pending.size();
+
+    listen_fd = NetProtocol::listen_endpoint(endpoint);
+    if (listen_fd == -1) {
+        return false;
+    }
+
+    std::cout << "[COORD] Listening on " << endpoint << " with " << progress.size()
+              << " exams (" << total_items << " questions)" << std::endl;
+    return true;
+}
+
+void Coordinator::accept_client() {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd == -1) {
+        return;
+    }
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes)); // No-op on Unix sockets
+
+    Client client;
+    client.conn = new Connection(fd);
+    client.conn->set_nonblocking();  // Writes wait for POLLOUT instead of blocking everyone
+    client.worker_id = -1;
+    client.wanted = 0;
+    clients[fd] = client;
+}
+
+void Coordinator::drop_client(int fd) {
+    std::map<int, Client>::iterator it = clients.find(fd);
+    if (it == clients.end()) {
+        return;
+    }
+
+    // Put unfinished leases back at the front so another worker picks them up
+    Client& client = it->second;
+    if (!client.leased.empty()) {
+        std::cout << "[COORD] Worker " << client.worker_id << " disconnected, re-queuing "
+                  << client.leased.size() << " leased questions" << std::endl;
+    }
+    for (size_t i = client.leased.size(); i > 0; i--) {
+        pending.push_front(client.leased[i - 1]);
+    }
+
+    delete client.conn;
+    clients.erase(it);
+}
+
+void Coordinator::serve_leases(Client& client) {
+    if (client.wanted <= 0) {
+        return;
+    }
+
+    // Skip items finished by another worker since they were re-queued
+    PayloadWriter lease;
+    std::vector<WorkItem> batch;
+    while (client.wanted > 0 && !pending.empty()) {
+        WorkItem item = pending.front();
+        pending.pop_front();
+        if (progress[item.student_number].done[item.question]) {
+            continue;
+        }
+        batch.push_back(item);
+        client.leased.push_back(item);
+        client.wanted--;
+    }
+
+    if (batch.empty()) {
+        return;
+    }
+
+    lease.put_u16((uint16_t)batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        lease.put_i64(batch[i].student_number);
+        lease.put_u8(batch[i].question);
+    }
+    client.conn->queue(lease.to_message(MSG_LEASE));
+}
+
+void Coordinator::record_result(Client& client, int64_t student_number, int question, uint32_t millis) {
+    for (size_t i = 0; i < client.leased.size(); i++) {
+        if (client.leased[i].student_number == student_number &&
+            client.leased[i].question == question) {
+            client.leased.erase(client.leased.begin() + i);
+            break;
+        }
+    }
+
+    std::map<int64_t, ExamProgress>::iterator it = progress.find(student_number);
+    if (it == progress.end() || question < 0 || question >= 5 || it->second.done[question]) {
+        return;
+    }
+
+    it->second.done[question] = true;
+    it->second.remaining--;
+    completed_items++;
+
+    std::cout << "[COORD] Worker " << client.worker_id << " marked question " << (question + 1)
+              << " for student " << student_number << " (" << millis << " ms)" << std::endl;
+
+    if (it->second.remaining == 0) {
+        std::cout << "[COORD] All questions marked for student " << student_number << std::endl;
+    }
+}
+
+void Coordinator::apply_rubric_fix(int question, char seen_char) {
+    if (question < 0 || question >= 5) {
+        return;
+    }
+
+    // Only apply the fix if the worker saw the current value, so two workers
+    // correcting the same line at once produce one change, not a lost update
+    std::string line = rubric.rubric_text[question];
+    size_t comma_pos = line.find(',');
+    if (comma_pos == std::string::npos || comma_pos + 2 >= line.length() ||
+        line[comma_pos + 2] != seen_char) {
+        return;
+    }
+
+    char next_char = seen_char + 1;
+    line[comma_pos + 2] = next_char;
+    strncpy(rubric.rubric_text[question], line.c_str(), 99);
+    rubric.rubric_text[question][99] = '\0';
+    FileManager::write_rubric_file(rubric.rubric_text);
+
+    std::cout << "[COORD] Changed rubric Q" << (question + 1) << " from '" << seen_char
+              << "' to '" << next_char << "'" << std::endl;
+
+    PayloadWriter update;
+    update.put_u8((uint8_t)question);
+    update.put_string(rubric.rubric_text[question]);
+    Message msg = update.to_message(MSG_RUBRIC_UPDATE);
+    for (std::map<int, Client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+        it->second.conn->queue(msg);
+    }
+}
+
+bool Coordinator::handle_message(Client& client, const Message& msg) {
+    PayloadReader reader(msg.payload);
+
+    switch (msg.type) {
+    case MSG_HELLO: {
+        client.worker_id = (int)reader.get_u32();
+        PayloadWriter welcome;
+        for (int q = 0; q < 5; q++) {
+            welcome.put_string(rubric.rubric_text[q]);
+        }
+        client.conn->queue(welcome.to_message(MSG_WELCOME));
+        std::cout << "[COORD] Worker " << client.worker_id << " connected" << std::endl;
+        break;
+    }
+    case MSG_LEASE_REQUEST: {
+        // A request replaces the previous one, so repeats cannot pile up a huge backlog
+        int requested = reader.get_u16();
+        client.wanted = std::min(requested, NetProtocol::MAX_LEASE_ITEMS);
+        break;
+    }
+    case MSG_RESULT: {
+        int64_t student = reader.get_i64();
+        int question = reader.get_u8();
+        uint32_t millis = reader.get_u32();
+        if (reader.ok()) {
+            record_result(client, student, question, millis);
+        }
+        break;
+    }
+    case MSG_RUBRIC_FIX: {
+        int question = reader.get_u8();
+        char seen_char = (char)reader.get_u8();
+        if (reader.ok()) {
+            apply_rubric_fix(question, seen_char);
+        }
+        break;
+    }
+    default:
+        std::cerr << "[COORD] Unknown message type " << (int)msg.type
+                  << " from worker " << client.worker_id << std::endl;
+        return false;
+    }
+
+    return reader.ok();
+}
+
+bool Coordinator::run() {
+    time_t idle_since = time(nullptr);
+    bool finished = false;
+
+    while (!stop_requested) {
+        if (completed_items >= total_items) {
+            finished = true;
+            break;
+        }
+
+        // With work left and no one to hand it to, give up after the idle timeout
+        if (!clients.empty()) {
+            idle_since = time(nullptr);
+        } else if (time(nullptr) - idle_since >= idle_timeout_seconds) {
+            std::cerr << "[COORD] Error: No workers connected for " << idle_timeout_seconds
+                      << " s with work left" << std::endl;
+            break;
+        }
+
+        std::vector<struct pollfd> fds;
+        struct pollfd listener;
+        listener.fd = listen_fd;
+        listener.events = POLLIN;
+        listener.revents = 0;
+        fds.push_back(listener);
+        for (std::map<int, Client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+            struct pollfd pfd;
+            pfd.fd = it->first;
+            pfd.events = POLLIN | (it->second.conn->has_output() ? POLLOUT : 0);
+            pfd.revents = 0;
+            fds.push_back(pfd);
+        }
+
+        if (poll(fds.data(), fds.size(), 1000) < 0) {
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            accept_client();
+        }
+
+        for (size_t i = 1; i < fds.size(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            Client& client = clients[fds[i].fd];
+            if (!client.conn->read_available()) {
+                drop_client(fds[i].fd);
+                continue;
+            }
+
+            Message msg;
+            bool healthy = true;
+            while (healthy && client.conn->next_message(msg)) {
+                healthy = handle_message(client, msg);
+            }
+            if (!healthy || !client.conn->is_open()) {
+                drop_client(fds[i].fd);
+            }
+        }
+
+        // Answer outstanding lease requests and write whatever each socket
+        // takes now; the rest waits for its POLLOUT
+        std::vector<int> broken;
+        for (std::map<int, Client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+            serve_leases(it->second);
+            if (!it->second.conn->send_available()) {
+                broken.push_back(it->first);
+            }
+        }
+        for (size_t i = 0; i < broken.size(); i++) {
+            drop_client(broken[i]);
+        }
+    }
+
+    if (!finished) {
+        std::cerr << "[COORD] Stopped with " << completed_items << " of " << total_items
+                  << " questions marked" << std::endl;
+        return false;
+    }
+
+    // Everything is marked, release the workers
+    Message shutdown = PayloadWriter().to_message(MSG_SHUTDOWN);
+    for (std::map<int, Client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+        it->second.conn->queue(shutdown);
+    }
+    send_to_clients(1000);
+
+    std::cout << "[COORD] All " << completed_items << " questions marked" << std::endl;
+    return true;
+}
+
+// Write the queued frames of every client, waiting up to timeout_ms in total
+// for sockets that are full
+void Coordinator::send_to_clients(int timeout_ms) {
+    time_t deadline = time(nullptr) + (timeout_ms + 999) / 1000;
+    while (true) {
+        std::vector<struct pollfd> fds;
+        for (std::map<int, Client>::iterator it = clients.begin(); it != clients.end(); ++it) {
+            if (it->second.conn->send_available() && it->second.conn->has_output()) {
+                struct pollfd pfd;
+                pfd.fd = it->first;
+                pfd.events = POLLOUT;
+                pfd.revents = 0;
+                fds.push_back(pfd);
+            }
+        }
+        if (fds.empty() || time(nullptr) >= deadline) {
+            return;
+        }
+        poll(fds.data(), fds.size(), 100);
+    }
+}
+
+void Coordinator::cleanup() {
+    while (!clients.empty()) {
+        delete clients.begin()->second.conn;
+        clients.erase(clients.begin());
+    }
+    if (listen_fd != -1) {
+        close(listen_fd);
+        listen_fd = -1;
+        NetProtocol::remove_endpoint(endpoint);
+    }
+}
+
+RubricData* Coordinator::get_rubric_data() {
+    return &rubric;
+}
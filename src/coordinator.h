@@ -0,0 +1,66 @@
+#ifndef COORDINATOR_H
+#define COORDINATOR_H
+
+#include "net_protocol.h"
+#include "shared_memory.h"
+#include <csignal>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+const int DEFAULT_IDLE_TIMEOUT = 60;  // Seconds without workers before giving up
+
+// Owns the exam list and rubric, and leases (exam, question) work items
+// to TA workers connected over TCP or Unix sockets.
+class Coordinator {
+private:
+    struct Client {
+        Connection* conn;
+        int worker_id;
+        std::vector<WorkItem> leased;  // Handed out but not yet reported
+        int wanted;                    // Items requested but not yet sent
+    };
+
+    struct ExamProgress {
+        bool done[5];
+        int remaining;
+    };
+
+    std::string endpoint;
+    int listen_fd;
+    RubricData rubric;
+    std::deque<WorkItem> pending;
+    std::map<int64_t, ExamProgress> progress;
+    std::map<int, Client> clients;  // Keyed by socket fd
+    size_t total_items;
+    size_t completed_items;
+    int idle_timeout_seconds;      // Stop once no worker was connected for this long
+
+    static volatile sig_atomic_t stop_requested;
+
+    void accept_client();
+    void drop_client(int fd);
+    bool handle_message(Client& client, const Message& msg);
+    void serve_leases(Client& client);
+    void record_result(Client& client, int64_t student_number, int question, uint32_t millis);
+    void apply_rubric_fix(int question, char seen_char);
+    void send_to_clients(int timeout_ms);
+
+public:
+    Coordinator(const std::string& endpoint, int idle_timeout_seconds = DEFAULT_IDLE_TIMEOUT);
+    ~Coordinator();
+
+    bool initialize();  // Load rubric and exams, start listening
+    // Serve workers until every question is marked. Returns false if stopped
+    // by a signal or after idle_timeout_seconds with work left and no workers.
+    bool run();
+    void cleanup();
+
+    // SIGINT/SIGTERM handler: run() reports progress and returns false
+    static void request_stop(int signum);
+
+    RubricData* get_rubric_data();
+};
+
+#endif
@@ -0,0 +1,200 @@
+// exam_queue.cpp
+// Shared-memory heap of exams waiting to be marked (streaming and priority mode)
+
+#include "exam_queue.h"
+#include "exam_stats.h"
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <iostream>
+
+ExamQueue::ExamQueue() : shm_id_queue(-1), queue_data(nullptr) {
+}
+
+ExamQueue::~ExamQueue() {
+    // Detach if still attached
+    if (queue_data != nullptr) {
+        shmdt(queue_data);
+    }
+}
+
+bool ExamQueue::initialize(int capacity, double aging_rate) {
+    key_t key = ftok(".", 'Q');
+    if (key == -1) {
+        std::cerr << "Error: ftok failed for exam queue" << std::endl;
+        return false;
+    }
+
+    size_t size = sizeof(ExamQueueData) + capacity * sizeof(QueuedExam);
+    shm_id_queue = shmget(key, size, IPC_CREAT | 0666);
+    if (shm_id_queue == -1) {
+        // A segment left by a crashed run is too small for this queue, replace it
+        int stale_id = shmget(key, 0, 0);
+        if (stale_id != -1) {
+            shmctl(stale_id, IPC_RMID, nullptr);
+            shm_id_queue = shmget(key, size, IPC_CREAT | 0666);
+        }
+    }
+    if (shm_id_queue == -1) {
+        std::cerr << "Error: shmget failed for exam queue" << std::endl;
+        return false;
+    }
+
+    queue_data = (ExamQueueData*)shmat(shm_id_queue, nullptr, 0);
+    if (queue_data == (void*)-1) {
+        std::cerr << "Error: shmat failed for exam queue" << std::endl;
+        queue_data = nullptr;
+        return false;
+    }
+
+    queue_data->count = 0;
+    queue_data->capacity = capacity;
+    queue_data->draining = false;
+    queue_data->aging_rate = aging_rate;
+    queue_data->start_us = ExamStats::now_us();
+
+    std::cout << "[QUEUE] Initialized successfully" << std::endl;
+    return true;
+}
+
+bool ExamQueue::attach() {
+    key_t key = ftok(".", 'Q');
+    int shm_id = (key == -1) ? -1 : shmget(key, 0, 0);
+    queue_data = (shm_id == -1) ? (ExamQueueData*)-1 : (ExamQueueData*)shmat(shm_id, nullptr, 0);
+    if (queue_data == (void*)-1) {
+        std::cerr << "Error: Could not attach to exam queue" << std::endl;
+        queue_data = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool ExamQueue::cleanup() {
+    bool success = true;
+
+    if (queue_data != nullptr) {
+        if (shmdt(queue_data) == -1) {
+            std::cerr << "Error: shmdt failed for exam queue" << std::endl;
+            success = false;
+        }
+        queue_data = nullptr;
+    }
+
+    if (shm_id_queue != -1) {
+        if (shmctl(shm_id_queue, IPC_RMID, nullptr) == -1) {
+            std::cerr << "Error: shmctl IPC_RMID failed for exam queue" << std::endl;
+            success = false;
+        }
+        shm_id_queue = -1;
+    }
+
+    return success;
+}
+
+QueuedExam* ExamQueue::entries() const {
+    return (QueuedExam*)(queue_data + 1);
+}
+
+static bool marked_before(const QueuedExam& a, const QueuedExam& b) {
+    return a.key < b.key || (a.key == b.key && a.student_number < b.student_number);
+}
+
+void ExamQueue::sift_up(int i) {
+    QueuedExam* heap = entries();
+    while (i > 0 && marked_before(heap[i], heap[(i - 1) / 2])) {
+        int parent = (i - 1) / 2;
+        QueuedExam tmp = heap[parent];
+        heap[parent] = heap[i];
+        heap[i] = tmp;
+        i = parent;
+    }
+}
+
+void ExamQueue::sift_down(int i) {
+    QueuedExam* heap = entries();
+    int count = queue_data->count;
+    while (true) {
+        int smallest = i;
+        int left = 2 * i + 1;
+        int right = 2 * i + 2;
+        if (left < count && marked_before(heap[left], heap[smallest])) {
+            smallest = left;
+        }
+        if (right < count && marked_before(heap[right], heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            break;
+        }
+        QueuedExam tmp = heap[smallest];
+        heap[smallest] = heap[i];
+        heap[i] = tmp;
+        i = smallest;
+    }
+}
+
+bool ExamQueue::push(int64_t student_number, int32_t priority) {
+    if (queue_data->count >= queue_data->capacity) {
+        return false;
+    }
+
+    // Key in millionths of a priority point: waiting one second at aging_rate 1
+    // is worth as much as one point of priority
+    int64_t waited_from = (int64_t)(ExamStats::now_us() - queue_data->start_us);
+    QueuedExam& entry = entries()[queue_data->count];
+    entry.key = (int64_t)(queue_data->aging_rate * waited_from) - (int64_t)priority * 1000000;
+    entry.student_number = student_number;
+    entry.priority = priority;
+    entry.reserved = 0;
+
+    sift_up(queue_data->count++);
+    return true;
+}
+
+bool ExamQueue::pop(int64_t& student_number, int32_t* priority) {
+    if (queue_data->count == 0) {
+        return false;
+    }
+
+    QueuedExam* heap = entries();
+    student_number = heap[0].student_number;
+    if (priority != nullptr) {
+        *priority = heap[0].priority;
+    }
+    heap[0] = heap[--queue_data->count];
+    sift_down(0);
+    return true;
+}
+
+int ExamQueue::update_priorities(const std::map<int64_t, int32_t>& priorities) {
+    QueuedExam* heap = entries();
+    int changed = 0;
+    for (int i = 0; i < queue_data->count; i++) {
+        std::map<int64_t, int32_t>::const_iterator it = priorities.find(heap[i].student_number);
+        int32_t priority = (it == priorities.end()) ? 0 : it->second;
+        if (priority != heap[i].priority) {
+            heap[i].key -= (int64_t)(priority - heap[i].priority) * 1000000;
+            heap[i].priority = priority;
+            changed++;
+        }
+    }
+
+    // Rebuild bottom-up
+    if (changed > 0) {
+        for (int i = queue_data->count / 2 - 1; i >= 0; i--) {
+            sift_down(i);
+        }
+    }
+    return changed;
+}
+
+int ExamQueue::size() const {
+    return queue_data->count;
+}
+
+void ExamQueue::set_draining() {
+    queue_data->draining = true;
+}
+
+bool ExamQueue::is_draining() const {
+    return queue_data->draining;
+}
@@ -0,0 +1,60 @@
+#ifndef EXAM_QUEUE_H
+#define EXAM_QUEUE_H
+
+#include <cstdint>
+#include <map>
+
+const int MAX_QUEUED_EXAMS = 4096;      // Default capacity (streaming mode)
+
+// One waiting exam. With aging, an exam gains aging_rate priority points per
+// second in the queue; since every exam ages at the same rate, ordering on
+// (aging_rate * enqueue time - priority) never changes and the heap stays valid.
+struct QueuedExam {
+    int64_t key;                // Smaller is marked sooner
+    int64_t student_number;     // Breaks ties, so equal priorities keep student order
+    int32_t priority;           // Higher is marked sooner
+    int32_t reserved;
+};
+
+// Header of the pending exams in shared memory; `capacity` QueuedExam
+// entries follow it directly, `count` of them in use as a min-heap
+struct ExamQueueData {
+    int count;
+    int capacity;
+    bool draining;              // No more exams will be added
+    double aging_rate;          // Priority points gained per second waiting, 0 for none
+    uint64_t start_us;          // Enqueue times are measured from here
+};
+
+// Shared work queue for streaming and priority mode. Callers serialize
+// push/pop with SemaphoreManager::lock_exam_load().
+class ExamQueue {
+private:
+    int shm_id_queue;
+    ExamQueueData* queue_data;
+
+    QueuedExam* entries() const;
+    void sift_up(int i);
+    void sift_down(int i);
+
+public:
+    ExamQueue();
+    ~ExamQueue();
+
+    bool initialize(int capacity = MAX_QUEUED_EXAMS, double aging_rate = 0);
+    bool cleanup();
+    bool attach();    // Use the queue created by initialize() in another process
+
+    bool push(int64_t student_number, int32_t priority = 0);   // False if the queue is full
+    bool pop(int64_t& student_number, int32_t* priority = nullptr);  // False if the queue is empty
+    int size() const;
+
+    // Apply changed priorities to exams already waiting, keeping the aging
+    // they have earned. Returns the number of exams whose priority changed.
+    int update_priorities(const std::map<int64_t, int32_t>& priorities);
+
+    void set_draining();
+    bool is_draining() const;
+};
+
+#endif
@@ -0,0 +1,196 @@
+// exam_stats.cpp
+// Per-exam lifecycle latencies: histograms, percentiles and SLO breaches
+
+#include "exam_stats.h"
+#include "shared_memory.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <time.h>
+
+uint64_t ExamStats::now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int bucket_index(uint64_t value_us) {
+    if (value_us < 32) {
+        return (int)value_us;
+    }
+    int exponent = 63 - __builtin_clzll(value_us);  // 2^exponent <= value < 2^(exponent+1)
+    if (exponent >= 40) {
+        return LATENCY_HIST_BUCKETS - 1;
+    }
+    int sub = (int)(value_us >> (exponent - 4)) - LATENCY_SUB_BUCKETS;
+    return 32 + (exponent - 5) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Largest value that falls into a bucket
+static uint64_t bucket_top(int index) {
+    if (index < 32) {
+        return (uint64_t)index;
+    }
+    int exponent = 5 + (index - 32) / LATENCY_SUB_BUCKETS;
+    uint64_t mantissa = LATENCY_SUB_BUCKETS + (index - 32) % LATENCY_SUB_BUCKETS;
+    return ((mantissa + 1) << (exponent - 4)) - 1;
+}
+
+static void record_latency(LatencyHistogram* hist, uint64_t value_us) {
+    __atomic_fetch_add(&hist->buckets[bucket_index(value_us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->total_us, value_us, __ATOMIC_RELAXED);
+
+    uint64_t seen = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+    while (value_us > seen &&
+           !__atomic_compare_exchange_n(&hist->max_us, &seen, value_us, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void ExamStats::mark_ta_ready(ExamStatsData* stats) {
+    uint64_t now = now_us();
+    uint64_t seen = __atomic_load_n(&stats->last_ready_us, __ATOMIC_RELAXED);
+    while (now > seen &&
+           !__atomic_compare_exchange_n(&stats->last_ready_us, &seen, now, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    __atomic_fetch_add(&stats->tas_ready, 1, __ATOMIC_RELEASE);
+}
+
+bool ExamStats::record_exam(ExamStatsData* stats, const ExamData* exam) {
+    uint64_t completed_us = 0;
+    for (int q = 0; q < 5; q++) {
+        uint64_t done = exam->question_done_us[q];
+        if (done > completed_us) {
+            completed_us = done;
+        }
+        if (done >= exam->loaded_us) {
+            record_latency(&stats->question, done - exam->loaded_us);
+        }
+    }
+
+    // Part A can lose a timestamp to a race; skip what cannot be ordered
+    if (completed_us < exam->loaded_us) {
+        return false;
+    }
+    uint64_t turnaround = completed_us - exam->loaded_us;
+    record_latency(&stats->turnaround, turnaround);
+
+    uint64_t first_claim = exam->first_claim_us;
+    if (first_claim >= exam->loaded_us && first_claim <= completed_us) {
+        record_latency(&stats->wait, first_claim - exam->loaded_us);
+        record_latency(&stats->marking, completed_us - first_claim);
+    }
+
+    if (stats->slo_us == 0 || turnaround <= stats->slo_us) {
+        return false;
+    }
+    uint64_t slot = __atomic_fetch_add(&stats->breach_count, 1, __ATOMIC_RELAXED);
+    if (slot < (uint64_t)MAX_SLO_BREACHES) {
+        stats->breaches[slot].student_number = exam->student_number;
+        stats->breaches[slot].turnaround_us = turnaround;
+    }
+    return true;
+}
+
+uint64_t ExamStats::percentile(const LatencyHistogram& hist, double p) {
+    if (hist.count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p / 100.0 * hist.count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist.buckets[i];
+        if (seen >= rank) {
+            uint64_t top = bucket_top(i);
+            return top < hist.max_us ? top : hist.max_us;
+        }
+    }
+    return hist.max_us;
+}
+
+static void print_hist(const char* name, const LatencyHistogram& hist) {
+    double mean_s = hist.count > 0 ? hist.total_us / 1e6 / hist.count : 0.0;
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "  " << std::left << std::setw(11) << name << std::right
+              << " n=" << std::setw(5) << hist.count << std::fixed << std::setprecision(3)
+              << "  p50=" << ExamStats::percentile(hist, 50) / 1e6 << "s"
+              << "  p90=" << ExamStats::percentile(hist, 90) / 1e6 << "s"
+              << "  p99=" << ExamStats::percentile(hist, 99) / 1e6 << "s"
+              << "  max=" << hist.max_us / 1e6 << "s"
+              << "  mean=" << mean_s << "s" << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+void ExamStats::print_report(const ExamStatsData* stats) {
+    std::cout << "\nExam latency (from load):" << std::endl;
+    print_hist("Turnaround", stats->turnaround);
+    print_hist("Wait", stats->wait);
+    print_hist("Marking", stats->marking);
+    print_hist("Question", stats->question);
+
+    if (stats->slo_us == 0) {
+        return;
+    }
+    std::cout << "  SLO " << stats->slo_us / 1e6 << "s: " << stats->breach_count << " of "
+              << stats->turnaround.count << " exams breached" << std::endl;
+    uint64_t listed = stats->breach_count < (uint64_t)MAX_SLO_BREACHES ? stats->breach_count : MAX_SLO_BREACHES;
+    for (uint64_t i = 0; i < listed; i++) {
+        std::cout << "    student " << stats->breaches[i].student_number << ": "
+                  << stats->breaches[i].turnaround_us / 1e6 << "s" << std::endl;
+    }
+}
+
+static void write_hist_json(std::ofstream& out, const char* name, const LatencyHistogram& hist) {
+    out << "    \"" << name << "\": {\"count\": " << hist.count
+        << ", \"total_us\": " << hist.total_us
+        << ", \"p50_us\": " << ExamStats::percentile(hist, 50)
+        << ", \"p90_us\": " << ExamStats::percentile(hist, 90)
+        << ", \"p99_us\": " << ExamStats::percentile(hist, 99)
+        << ", \"max_us\": " << hist.max_us
+        << ", \"buckets\": [";
+
+    // Non-empty buckets only, as [top_us, count]
+    bool first = true;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        if (hist.buckets[i] == 0) {
+            continue;
+        }
+        out << (first ? "" : ", ") << "[" << bucket_top(i) << ", " << hist.buckets[i] << "]";
+        first = false;
+    }
+    out << "]}";
+}
+
+bool ExamStats::write_json(const ExamStatsData* stats, const std::string& path) {
+    std::ofstream out(path.c_str());
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    out << "{\n  \"slo_us\": " << stats->slo_us << ",\n  \"histograms\": {\n";
+    write_hist_json(out, "turnaround", stats->turnaround);
+    out << ",\n";
+    write_hist_json(out, "wait", stats->wait);
+    out << ",\n";
+    write_hist_json(out, "marking", stats->marking);
+    out << ",\n";
+    write_hist_json(out, "question", stats->question);
+    out << "\n  },\n  \"slo_breach_count\": " << stats->breach_count << ",\n  \"slo_breaches\": [";
+
+    uint64_t listed = stats->breach_count < (uint64_t)MAX_SLO_BREACHES ? stats->breach_count : MAX_SLO_BREACHES;
+    for (uint64_t i = 0; i < listed; i++) {
+        out << (i == 0 ? "" : ", ") << "{\"student\": " << stats->breaches[i].student_number
+            << ", \"turnaround_us\": " << stats->breaches[i].turnaround_us << "}";
+    }
+    out << "]\n}\n";
+
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,64 @@
+#ifndef EXAM_STATS_H
+#define EXAM_STATS_H
+
+#include <cstdint>
+#include <string>
+#include "race_detector.h"
+
+struct ExamData;
+
+// Log-linear buckets: values below 32 us are exact, above that each power of
+// two is split into 16 buckets (about 6% resolution) up to 2^40 us
+const int LATENCY_SUB_BUCKETS = 16;
+const int LATENCY_HIST_BUCKETS = 32 + (40 - 5) * LATENCY_SUB_BUCKETS;
+const int MAX_SLO_BREACHES = 256;
+
+struct LatencyHistogram {
+    uint64_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+    uint64_t buckets[LATENCY_HIST_BUCKETS];
+};
+
+struct SloBreach {
+    int64_t student_number;
+    uint64_t turnaround_us;
+};
+
+// Per-exam latency statistics (in shared memory)
+struct ExamStatsData {
+    uint64_t slo_us;                // 0 when no SLO is set
+    LatencyHistogram turnaround;    // Loaded until all 5 questions are marked
+    LatencyHistogram wait;          // Loaded until the first question is claimed
+    LatencyHistogram marking;       // First claim until all 5 questions are marked
+    LatencyHistogram question;      // Loaded until each question is marked
+    uint64_t tas_ready;             // TAs that have reached TAProcess::run()
+    uint64_t last_ready_us;         // now_us() when the latest of them did
+    uint64_t breach_count;
+    SloBreach breaches[MAX_SLO_BREACHES];  // First MAX_SLO_BREACHES breaches
+    RaceCounters races;             // Only updated with --detect-races
+};
+
+class ExamStats {
+public:
+    // CLOCK_MONOTONIC in microseconds, comparable across TA processes
+    static uint64_t now_us();
+
+    // Called by each TA once it is ready to mark
+    static void mark_ta_ready(ExamStatsData* stats);
+
+    // Add a fully marked exam to the histograms. Returns true if its
+    // turnaround breached the SLO. Safe to call from several TAs at once.
+    static bool record_exam(ExamStatsData* stats, const ExamData* exam);
+
+    // Value at percentile p (0-100), reported as the top of its bucket
+    static uint64_t percentile(const LatencyHistogram& hist, double p);
+
+    // Print p50/p90/p99/max for every histogram and the SLO breaches
+    static void print_report(const ExamStatsData* stats);
+
+    // Write the same report plus the raw buckets as JSON
+    static bool write_json(const ExamStatsData* stats, const std::string& path);
+};
+
+#endif
@@ -3,14 +3,76 @@
 #include <sstream>
 #include <iostream>
 #include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <thread>
 
 const std::string FileManager::RUBRIC_FILENAME = "data/rubric.txt";
 const std::string FileManager::EXAM_DIR = "data/exams/";
+const std::string FileManager::PACK_EXTENSION = ".pack";
+const std::string FileManager::PRIORITY_FILENAME = "priorities.txt";
+const int64_t FileManager::TERMINATION_STUDENT = 9999;
 
-std::vector<int> FileManager::get_exam_list() {
-    std::vector<int> exam_list;
+std::vector<std::string> FileManager::pack_files;
+std::map<int64_t, ExamLocation> FileManager::pack_index;
+
+// Pack file layout: "EXPK", u32 version, u64 count, then count index
+// entries (i64 student, i64 offset, u32 length), then the exam texts
+static const char PACK_MAGIC[4] = {'E', 'X', 'P', 'K'};
+static const uint32_t PACK_VERSION = 1;
+
+// Spread student numbers evenly over the 256 x 256 shard directories
+static uint64_t shard_hash(int64_t student_number) {
+    uint64_t x = (uint64_t)student_number + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static bool is_shard_dir_name(const char* name) {
+    return strlen(name) == 2 && isxdigit((unsigned char)name[0]) && isxdigit((unsigned char)name[1]);
+}
+
+// Collect exam files from the given top-level shard directories ("ab/cd/")
+static void scan_shard_dirs(const std::vector<std::string>& shard_dirs, size_t first, size_t step,
+                            std::vector<int64_t>* exam_list) {
+    for (size_t i = first; i < shard_dirs.size(); i += step) {
+        DIR* outer = opendir(shard_dirs[i].c_str());
+        if (!outer) {
+            continue;
+        }
+        
+        struct dirent* sub;
+        while ((sub = readdir(outer)) != nullptr) {
+            if (!is_shard_dir_name(sub->d_name)) {
+                continue;
+            }
+            std::string inner_path = shard_dirs[i] + sub->d_name + "/";
+            DIR* inner = opendir(inner_path.c_str());
+            if (!inner) {
+                continue;
+            }
+            
+            struct dirent* entry;
+            while ((entry = readdir(inner)) != nullptr) {
+                int64_t student_num;
+                if (FileManager::parse_exam_filename(entry->d_name, student_num)) {
+                    exam_list->push_back(student_num);
+                }
+            }
+            closedir(inner);
+        }
+        closedir(outer);
+    }
+}
+
+std::vector<int64_t> FileManager::get_exam_list() {
+    std::vector<int64_t> exam_list;
+    std::vector<std::string> shard_dirs;
+    std::vector<std::string> packs;
     DIR* dir = opendir(EXAM_DIR.c_str());
     
     if (!dir) {
@@ -21,49 +83,197 @@ std::vector<int> FileManager::get_exam_list() {
     struct dirent* entry;
     while ((entry = readdir(dir)) != nullptr) {
         std::string filename = entry->d_name;
+        int64_t student_num;
         
-        // Look for files matching "exam_XXXX.txt"
-        if (filename.find("exam_") == 0 && filename.find(".txt") != std::string::npos) {
-            // Extract student number
-            std::string num_str = filename.substr(5, 4); // Get XXXX from exam_XXXX.txt
-            int student_num = std::stoi(num_str);
+        if (parse_exam_filename(filename, student_num)) {
             exam_list.push_back(student_num);
         }
+        else if (is_shard_dir_name(entry->d_name)) {
+            shard_dirs.push_back(EXAM_DIR + filename + "/");
+        }
+        else if (is_pack_file_name(filename)) {
+            packs.push_back(EXAM_DIR + filename);
+        }
     }
     closedir(dir);
     
-    // Sort in ascending order
+    // Walk the shard directories with several threads, each on its own slice
+    if (!shard_dirs.empty()) {
+        size_t num_threads = std::thread::hardware_concurrency();
+        num_threads = std::max<size_t>(1, std::min<size_t>(num_threads, 8));
+        num_threads = std::min(num_threads, shard_dirs.size());
+        
+        std::vector<std::vector<int64_t> > partial(num_threads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < num_threads; t++) {
+            workers.push_back(std::thread(scan_shard_dirs, std::cref(shard_dirs), t, num_threads, &partial[t]));
+        }
+        for (size_t t = 0; t < num_threads; t++) {
+            workers[t].join();
+            exam_list.insert(exam_list.end(), partial[t].begin(), partial[t].end());
+        }
+    }
+    
+    index_packs(packs, exam_list);
+    
+    // Sort in ascending order, an exam found in more than one place is marked once
     std::sort(exam_list.begin(), exam_list.end());
+    exam_list.erase(std::unique(exam_list.begin(), exam_list.end()), exam_list.end());
+    
+    // The termination exam always comes last, student numbers may now exceed it
+    std::vector<int64_t>::iterator marker = std::find(exam_list.begin(), exam_list.end(), TERMINATION_STUDENT);
+    if (marker != exam_list.end() && is_termination_exam(TERMINATION_STUDENT)) {
+        std::rotate(marker, marker + 1, exam_list.end());
+    }
     
     return exam_list;
 }
 
-bool FileManager::read_exam_file(int student_number, int& student_num_out) {
+bool FileManager::is_pack_file_name(const std::string& filename) {
+    return filename.length() > PACK_EXTENSION.length() &&
+           filename.compare(filename.length() - PACK_EXTENSION.length(),
+                            PACK_EXTENSION.length(), PACK_EXTENSION) == 0;
+}
+
+void FileManager::index_packs(std::vector<std::string>& packs, std::vector<int64_t>& exam_list) {
+    // Pack files are read in name order so pack ids are stable between runs
+    std::sort(packs.begin(), packs.end());
+    pack_files.clear();
+    pack_index.clear();
+    for (size_t i = 0; i < packs.size(); i++) {
+        pack_files.push_back(packs[i]);
+        if (!scan_pack_file(packs[i], exam_list)) {
+            std::cerr << "Error: Could not read exam pack: " << packs[i] << std::endl;
+        }
+    }
+}
+
+bool FileManager::scan_pack_file(const std::string& path, std::vector<int64_t>& exam_list) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&count, sizeof(count));
+    if (!file || memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0 || version != PACK_VERSION) {
+        return false;
+    }
+    
+    int pack_id = (int)pack_files.size() - 1;
+    for (uint64_t i = 0; i < count; i++) {
+        int64_t student_num;
+        ExamLocation location;
+        location.pack_id = pack_id;
+        file.read((char*)&student_num, sizeof(student_num));
+        file.read((char*)&location.offset, sizeof(location.offset));
+        file.read((char*)&location.length, sizeof(location.length));
+        if (!file) {
+            return false;
+        }
+        pack_index[student_num] = location;
+        exam_list.push_back(student_num);
+    }
+    
+    return true;
+}
+
+bool FileManager::parse_exam_filename(const std::string& filename, int64_t& student_num_out) {
+    // Look for files matching "exam_<digits>.txt"
+    const size_t prefix_len = 5;  // "exam_"
+    const size_t suffix_len = 4;  // ".txt"
+    if (filename.length() <= prefix_len + suffix_len || filename.compare(0, prefix_len, "exam_") != 0 ||
+        filename.compare(filename.length() - suffix_len, suffix_len, ".txt") != 0) {
+        return false;
+    }
+    
+    // Extract student number, at most 18 digits so it always fits in 64 bits
+    std::string num_str = filename.substr(prefix_len, filename.length() - prefix_len - suffix_len);
+    if (num_str.length() > 18 || num_str.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    int64_t student_num = std::stoll(num_str);
+    
+    // Exams are opened by the canonical name, so "exam_00001.txt" would be
+    // listed as student 1 but read from exam_0001.txt; skip such names
+    std::string canonical = get_exam_filename(student_num).substr(EXAM_DIR.length());
+    if (filename != canonical) {
+        std::cerr << "Warning: Skipping " << filename << ", expected the name " << canonical << std::endl;
+        return false;
+    }
+    student_num_out = student_num;
+    return true;
+}
+
+bool FileManager::parse_student_line(const std::string& line, int64_t& student_num_out) {
+    // Extract number after "Student: "
+    size_t pos = line.find("Student:");
+    if (pos == std::string::npos) {
+        return false;
+    }
+    
+    std::string num_str = line.substr(pos + 8); // Skip "Student:"
+    // Remove whitespace
+    num_str.erase(0, num_str.find_first_not_of(" \t\r\n"));
+    if (num_str.empty() || !isdigit((unsigned char)num_str[0])) {
+        return false;
+    }
+    student_num_out = std::stoll(num_str);
+    return true;
+}
+
+bool FileManager::read_exam_file(int64_t student_number, int64_t& student_num_out) {
+    std::string line;
+    
+    std::map<int64_t, ExamLocation>::const_iterator packed = pack_index.find(student_number);
+    if (packed != pack_index.end()) {
+        const ExamLocation& location = packed->second;
+        return read_packed_exam(pack_files[location.pack_id], location.offset, location.length, student_num_out);
+    }
+    
+    // Flat layout first, then the sharded layout
     std::string filename = get_exam_filename(student_number);
     std::ifstream file(filename);
+    if (!file.is_open()) {
+        filename = get_sharded_exam_filename(student_number);
+        file.open(filename);
+    }
     
     if (!file.is_open()) {
         std::cerr << "Error: Could not open exam file: " << filename << std::endl;
         return false;
     }
     
-    std::string line;
     // Read first line which should contain "Student: XXXX"
-    if (std::getline(file, line)) {
-        // Extract number after "Student: "
-        size_t pos = line.find("Student:");
-        if (pos != std::string::npos) {
-            std::string num_str = line.substr(pos + 8); // Skip "Student:"
-            // Remove whitespace
-            num_str.erase(0, num_str.find_first_not_of(" \t\r\n"));
-            student_num_out = std::stoi(num_str);
-            file.close();
-            return true;
-        }
-    }
+    bool found = std::getline(file, line) && parse_student_line(line, student_num_out);
     
     file.close();
-    return false;
+    return found;
+}
+
+bool FileManager::read_packed_exam(const std::string& pack_path, int64_t offset, uint32_t length,
+                                   int64_t& student_num_out) {
+    std::ifstream pack(pack_path, std::ios::binary);
+    if (!pack.is_open()) {
+        std::cerr << "Error: Could not open exam pack: " << pack_path << std::endl;
+        return false;
+    }
+    
+    std::string text(length, '\0');
+    pack.seekg(offset);
+    pack.read(&text[0], length);
+    if (!pack) {
+        std::cerr << "Error: Truncated exam pack: " << pack_path << std::endl;
+        return false;
+    }
+    
+    // Read first line which should contain "Student: XXXX"
+    std::string line = text.substr(0, text.find('\n'));
+    return parse_student_line(line, student_num_out);
 }
 
 bool FileManager::read_rubric_file(char rubric[][100]) {
@@ -87,6 +297,36 @@ bool FileManager::read_rubric_file(char rubric[][100]) {
     return (line_num == 5); // Should have exactly 5 lines
 }
 
+bool FileManager::read_priorities(std::map<int64_t, int32_t>& priorities) {
+    priorities.clear();
+    
+    std::ifstream file(EXAM_DIR + PRIORITY_FILENAME);
+    if (!file.is_open()) {
+        return true;
+    }
+    
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line)) {
+        line_num++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        
+        long long student;
+        int priority;
+        if (sscanf(line.c_str(), "%lld %d", &student, &priority) != 2) {
+            std::cerr << "Warning: Ignoring line " << line_num << " of " << EXAM_DIR + PRIORITY_FILENAME
+                      << ": " << line << std::endl;
+            continue;
+        }
+        priorities[student] = priority;
+    }
+    
+    file.close();
+    return true;
+}
+
 bool FileManager::write_rubric_file(const char rubric[][100]) {
     std::ofstream file(RUBRIC_FILENAME);
     
@@ -103,8 +343,101 @@ bool FileManager::write_rubric_file(const char rubric[][100]) {
     return true;
 }
 
-std::string FileManager::get_exam_filename(int student_number) {
-    char buffer[20];
-    snprintf(buffer, sizeof(buffer), "exam_%04d.txt", student_number);
+int64_t FileManager::get_exam_file_size(int64_t student_number) {
+    std::map<int64_t, ExamLocation>::const_iterator packed = pack_index.find(student_number);
+    if (packed != pack_index.end()) {
+        return packed->second.length;
+    }
+    
+    struct stat info;
+    if (stat(get_exam_filename(student_number).c_str(), &info) == 0 ||
+        stat(get_sharded_exam_filename(student_number).c_str(), &info) == 0) {
+        return info.st_size;
+    }
+    return -1;
+}
+
+std::string FileManager::get_exam_filename(int64_t student_number) {
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "exam_%04lld.txt", (long long)student_number);
+    return EXAM_DIR + std::string(buffer);
+}
+
+std::string FileManager::get_sharded_exam_filename(int64_t student_number) {
+    uint64_t hash = shard_hash(student_number);
+    char buffer[60];
+    snprintf(buffer, sizeof(buffer), "%02x/%02x/exam_%04lld.txt",
+             (unsigned)(hash & 0xFF), (unsigned)((hash >> 8) & 0xFF), (long long)student_number);
     return EXAM_DIR + std::string(buffer);
-}
\ No newline at end of file
+}
+
+bool FileManager::is_termination_exam(int64_t student_number) {
+    return student_number == TERMINATION_STUDENT &&
+           pack_index.find(student_number) == pack_index.end() &&
+           access(get_exam_filename(student_number).c_str(), F_OK) == 0;
+}
+
+bool FileManager::is_packed(int64_t student_number) {
+    return pack_index.find(student_number) != pack_index.end();
+}
+
+bool FileManager::get_pack_location(int64_t student_number, ExamLocation& location_out) {
+    std::map<int64_t, ExamLocation>::const_iterator packed = pack_index.find(student_number);
+    if (packed == pack_index.end()) {
+        return false;
+    }
+    location_out = packed->second;
+    return true;
+}
+
+const std::vector<std::string>& FileManager::get_pack_files() {
+    return pack_files;
+}
+
+bool FileManager::write_exam_pack(const std::string& pack_path, const std::vector<int64_t>& students) {
+    // Read every exam first so the index can be written before the texts
+    std::vector<int64_t> ids;
+    std::vector<std::string> texts;
+    for (size_t i = 0; i < students.size(); i++) {
+        std::string filename = get_exam_filename(students[i]);
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            filename = get_sharded_exam_filename(students[i]);
+            file.open(filename);
+        }
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open exam file: " << filename << std::endl;
+            return false;
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        ids.push_back(students[i]);
+        texts.push_back(text.str());
+    }
+    
+    std::ofstream pack(pack_path, std::ios::binary | std::ios::trunc);
+    if (!pack.is_open()) {
+        std::cerr << "Error: Could not write exam pack: " << pack_path << std::endl;
+        return false;
+    }
+    
+    uint64_t count = ids.size();
+    pack.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+    pack.write((const char*)&PACK_VERSION, sizeof(PACK_VERSION));
+    pack.write((const char*)&count, sizeof(count));
+    
+    const int64_t entry_size = sizeof(int64_t) * 2 + sizeof(uint32_t);
+    int64_t offset = sizeof(PACK_MAGIC) + sizeof(PACK_VERSION) + sizeof(count) + count * entry_size;
+    for (size_t i = 0; i < ids.size(); i++) {
+        uint32_t length = (uint32_t)texts[i].length();
+        pack.write((const char*)&ids[i], sizeof(ids[i]));
+        pack.write((const char*)&offset, sizeof(offset));
+        pack.write((const char*)&length, sizeof(length));
+        offset += length;
+    }
+    for (size_t i = 0; i < texts.size(); i++) {
+        pack.write(texts[i].data(), texts[i].length());
+    }
+    
+    return (bool)pack;
+}
@@ -1,19 +1,51 @@
 #ifndef FILE_MANAGER_H
 #define FILE_MANAGER_H
 
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 
+// Where an exam stored inside a pack file lives
+struct ExamLocation {
+    int pack_id;        // Index into the list of pack files
+    int64_t offset;     // Byte offset of the exam text inside the pack
+    uint32_t length;    // Length of the exam text in bytes
+};
+
 class FileManager {
+private:
+    // Exams found inside pack files by the last get_exam_list() scan
+    static std::vector<std::string> pack_files;
+    static std::map<int64_t, ExamLocation> pack_index;
+    
+    static bool is_pack_file_name(const std::string& filename);
+    static void index_packs(std::vector<std::string>& packs, std::vector<int64_t>& exam_list);
+    static bool scan_pack_file(const std::string& path, std::vector<int64_t>& exam_list);
+    static bool parse_student_line(const std::string& line, int64_t& student_num_out);
+
 public:
     static const std::string RUBRIC_FILENAME;
     static const std::string EXAM_DIR;
+    static const std::string PACK_EXTENSION;
+    static const std::string PRIORITY_FILENAME;
+    static const int64_t TERMINATION_STUDENT;
     
-    // Get list of all exam student numbers in order
-    static std::vector<int> get_exam_list();
+    // Get list of all exam student numbers in order. Scans the flat exam
+    // directory, the sharded subdirectories (in parallel) and pack files.
+    static std::vector<int64_t> get_exam_list();
+    
+    // Extract the student number from an "exam_<digits>.txt" filename. Only
+    // the name get_exam_filename() gives (at least 4 digits, no extra leading
+    // zeros) is accepted.
+    static bool parse_exam_filename(const std::string& filename, int64_t& student_num_out);
     
     // Read student number from exam file
-    static bool read_exam_file(int student_number, int& student_num_out);
+    static bool read_exam_file(int64_t student_number, int64_t& student_num_out);
+    
+    // Read student number from an exam stored at a known place in a pack file
+    static bool read_packed_exam(const std::string& pack_path, int64_t offset, uint32_t length,
+                                 int64_t& student_num_out);
     
     // Read rubric from file into array
     static bool read_rubric_file(char rubric[][100]);
@@ -21,8 +53,35 @@ public:
     // Write rubric array back to file
     static bool write_rubric_file(const char rubric[][100]);
     
-    // Get filename for a given student number
-    static std::string get_exam_filename(int student_number);
+    // Read "<student> <priority>" lines from the priority sidecar file in
+    // EXAM_DIR. Students not listed have priority 0; a missing file is not an error.
+    static bool read_priorities(std::map<int64_t, int32_t>& priorities);
+    
+    // Size of an exam's text in bytes, -1 if it cannot be found
+    static int64_t get_exam_file_size(int64_t student_number);
+    
+    // Get filename for a given student number in the flat layout
+    static std::string get_exam_filename(int64_t student_number);
+    
+    // Get filename for a given student number in the sharded layout
+    // ("<EXAM_DIR>/ab/cd/exam_<n>.txt", ab and cd taken from a hash of n)
+    static std::string get_sharded_exam_filename(int64_t student_number);
+    
+    // Only the legacy flat exam_9999.txt ends a batch run; a student 9999
+    // stored in a shard or pack is marked like any other
+    static bool is_termination_exam(int64_t student_number);
+    
+    // Whether the last get_exam_list() scan found this exam in a pack file
+    static bool is_packed(int64_t student_number);
+    
+    // Where the last get_exam_list() scan found a packed exam; false if it is not packed
+    static bool get_pack_location(int64_t student_number, ExamLocation& location_out);
+    
+    // Pack files of the last get_exam_list() scan, indexed by ExamLocation::pack_id
+    static const std::vector<std::string>& get_pack_files();
+    
+    // Bundle the given exams into one pack file
+    static bool write_exam_pack(const std::string& pack_path, const std::vector<int64_t>& students);
 };
 
-#endif 
\ No newline at end of file
+#endif
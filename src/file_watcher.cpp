@@ -0,0 +1,85 @@
+// file_watcher.cpp
+// inotify wrapper used to pick up files written while the program runs
+
+#include "file_watcher.h"
+#include <iostream>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+FileWatcher::FileWatcher() : inotify_fd(-1), watch_fd(-1) {
+}
+
+FileWatcher::~FileWatcher() {
+    cleanup();
+}
+
+bool FileWatcher::initialize(const std::string& dir) {
+    directory = dir;
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) {
+        std::cerr << "[WATCH] Error: inotify_init1 failed" << std::endl;
+        return false;
+    }
+
+    // Editors and copy tools either rewrite in place or rename a temp file
+    watch_fd = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch_fd == -1) {
+        std::cerr << "[WATCH] Error: could not watch " << directory << std::endl;
+        close(inotify_fd);
+        inotify_fd = -1;
+        return false;
+    }
+
+    return true;
+}
+
+bool FileWatcher::cleanup() {
+    if (inotify_fd != -1) {
+        if (watch_fd != -1) {
+            inotify_rm_watch(inotify_fd, watch_fd);
+            watch_fd = -1;
+        }
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+    return true;
+}
+
+int FileWatcher::get_fd() const {
+    return inotify_fd;
+}
+
+bool FileWatcher::read_events(std::vector<std::string>& names, bool* overflowed) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (true) {
+        ssize_t len = read(inotify_fd, buffer, sizeof(buffer));
+        if (len == -1) {
+            if (errno == EAGAIN) {
+                return true;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[WATCH] Error: reading inotify events failed" << std::endl;
+            return false;
+        }
+
+        for (char* ptr = buffer; ptr < buffer + len; ) {
+            struct inotify_event* event = (struct inotify_event*)ptr;
+            if (event->mask & IN_Q_OVERFLOW) {
+                std::cerr << "[WATCH] Event queue overflowed, changes in " << directory
+                          << " were missed" << std::endl;
+                if (overflowed != nullptr) {
+                    *overflowed = true;
+                }
+            }
+            else if (event->len > 0) {
+                names.push_back(event->name);
+            }
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
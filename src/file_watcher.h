@@ -0,0 +1,31 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <string>
+#include <vector>
+
+// Watches one directory with inotify and reports files that were fully
+// written (closed after writing) or moved into it.
+class FileWatcher {
+private:
+    int inotify_fd;
+    int watch_fd;
+    std::string directory;
+
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    bool initialize(const std::string& dir);
+    bool cleanup();
+
+    // Descriptor to poll() for readability
+    int get_fd() const;
+
+    // Read pending events; appends the names of changed files. If the kernel
+    // queue overflowed, events were lost and *overflowed is set: rescan the
+    // directory instead of trusting names.
+    bool read_events(std::vector<std::string>& names, bool* overflowed = nullptr);
+};
+
+#endif
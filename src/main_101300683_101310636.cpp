@@ -6,24 +6,114 @@
 #include <cstdlib>
 #include <vector>
 #include <signal.h>
+#include <cstring>
+#include <string>
 #include "shared_memory.h"
 #include "file_manager.h"
 #include "ta_process.h"
+#include "checkpoint.h"
+#include "exam_stats.h"
+#include "workload_profile.h"
+#include "results.h"
+#include "ta_launcher.h"
+#include "race_detector.h"
 
 using namespace std;
 
 void print_usage(const char* program_name) {
-    cout << "Usage: " << program_name << " <number_of_TAs>" << endl;
+    cout << "Usage: " << program_name << " <number_of_TAs> [--resume] [--slo <seconds>] [--json <path>]" << endl;
+    cout << "       [--profile <path>] [--spawn] [--detect-races]" << endl;
     cout << "  number_of_TAs: must be >= 2" << endl;
+    cout << "  --resume: continue from " << Checkpoint::CHECKPOINT_FILENAME << endl;
+    cout << "  --slo: flag exams whose turnaround (load to fully marked) exceeds this" << endl;
+    cout << "  --json: also write the exam latency report to this file" << endl;
+    cout << "  --profile: marking/review delays, correction rates and trace to replay" << endl;
+    cout << "  --spawn: start TAs as " << TALauncher::WORKER_BINARY << " processes with posix_spawn" << endl;
+    cout << "  --detect-races: count double claims, duplicate/skipped loads and lost rubric updates" << endl;
+}
+
+volatile sig_atomic_t stop_requested = 0;
+
+void request_stop(int) {
+    stop_requested = 1;
+}
+
+// Wait for all TAs while checkpointing the shared state every interval.
+// Returns false if SIGINT/SIGTERM interrupted the run. TAs that exited with
+// an error (an exam could not be loaded) are counted in failed_tas.
+bool wait_for_tas(const vector<pid_t>& ta_pids, SharedMemory& shared_mem, int& failed_tas) {
+    size_t remaining = ta_pids.size();
+    int since_checkpoint_ms = 0;
+    bool stopped = false;
+    
+    while (remaining > 0) {
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0) {
+            for (size_t i = 0; i < ta_pids.size(); i++) {
+                if (ta_pids[i] == pid) {
+                    cout << "[MAIN] TA process " << pid << " (TA " << i << ") terminated with status " 
+                         << WEXITSTATUS(status) << endl;
+                    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                        failed_tas++;
+                    }
+                    remaining--;
+                }
+            }
+            continue;
+        }
+        
+        if (stop_requested && !stopped) {
+            cout << "[MAIN] Interrupted, stopping TAs" << endl;
+            for (pid_t p : ta_pids) {
+                kill(p, SIGTERM);
+            }
+            stopped = true;
+        }
+        
+        usleep(100000); // 0.1 seconds
+        since_checkpoint_ms += 100;
+        if (!stopped && since_checkpoint_ms >= Checkpoint::INTERVAL_MS) {
+            Checkpoint::save(&shared_mem, nullptr);
+            since_checkpoint_ms = 0;
+        }
+    }
+    
+    return !stopped;
 }
 
 int main(int argc, char* argv[]) {
     // Check command line arguments
-    if (argc != 2) {
+    if (argc < 2) {
         print_usage(argv[0]);
         return 1;
     }
     
+    bool resume = false;
+    double slo_seconds = 0;
+    string json_path;
+    string profile_path;
+    bool spawn_tas = false;
+    bool detect_races = false;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--resume") == 0) {
+            resume = true;
+        } else if (strcmp(argv[i], "--slo") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) {
+            slo_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--spawn") == 0) {
+            spawn_tas = true;
+        } else if (strcmp(argv[i], "--detect-races") == 0) {
+            detect_races = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
     int num_tas = atoi(argv[1]);
     if (num_tas < 2) {
         cerr << "Error: Number of TAs must be at least 2" << endl;
@@ -35,6 +125,14 @@ int main(int argc, char* argv[]) {
     cout << "    TA Exam Marking System (Part A - Unsynchronized)       " << endl;
     cout << "============================================================" << endl;
     cout << "Number of TAs: " << num_tas << endl;
+    
+    WorkloadProfile workload;
+    if (!profile_path.empty()) {
+        if (!workload.load(profile_path)) {
+            return 1;
+        }
+        workload.print_summary();
+    }
     cout << "------------------------------------------------------------" << endl;
     
     // Initialize shared memory in parent process
@@ -43,6 +141,7 @@ int main(int argc, char* argv[]) {
         cerr << "Error: Failed to initialize shared memory" << endl;
         return 1;
     }
+    shared_mem.get_exam_stats()->slo_us = (uint64_t)(slo_seconds * 1000000);
     
     // Load initial rubric
     if (!shared_mem.load_rubric_from_file()) {
@@ -52,7 +151,7 @@ int main(int argc, char* argv[]) {
     }
     
     // Get list of exams to process
-    vector<int> exam_list = FileManager::get_exam_list();
+    vector<int64_t> exam_list = FileManager::get_exam_list();
     if (exam_list.empty()) {
         cerr << "Error: No exam files found in " << FileManager::EXAM_DIR << endl;
         shared_mem.cleanup();
@@ -61,20 +160,59 @@ int main(int argc, char* argv[]) {
     
     cout << "Found " << exam_list.size() << " exam files" << endl;
     
-    // Load first exam
-    if (!shared_mem.load_exam_from_file(exam_list[0], 0)) {
-        cerr << "Error: Failed to load first exam" << endl;
+    // Share one read-only copy of the list with every TA
+    if (!shared_mem.publish_exam_list(exam_list)) {
+        cerr << "Error: Failed to share exam list" << endl;
         shared_mem.cleanup();
         return 1;
     }
+    vector<int64_t>().swap(exam_list);
     
-    cout << "Starting marking process with student " << exam_list[0] << endl;
+    if (resume) {
+        // Pick up where the last checkpoint left off
+        CheckpointData saved;
+        if (!Checkpoint::load(saved) || !Checkpoint::restore(saved, &shared_mem)) {
+            cerr << "Error: Failed to resume from checkpoint" << endl;
+            shared_mem.cleanup();
+            return 1;
+        }
+    } else {
+        // Load first exam
+        int64_t first_student = shared_mem.get_exam_entry(0)->student_number;
+        if (!shared_mem.load_exam_from_file(first_student, 0)) {
+            cerr << "Error: Failed to load first exam" << endl;
+            shared_mem.cleanup();
+            return 1;
+        }
+        
+        cout << "Starting marking process with student " << first_student << endl;
+    }
     cout << "============================================================" << endl << endl;
     
+    // Each TA appends to its own part file, merged once marking is done
+    if (!Results::prepare(resume)) {
+        shared_mem.cleanup();
+        return 1;
+    }
+    if (detect_races) {
+        RaceDetector::start(&shared_mem.get_exam_stats()->races,
+                            shared_mem.get_exam_data()->current_exam_index);
+    }
+    
+    // Spawned workers get the same options as forked TAs
+    vector<string> worker_args;
+    if (!profile_path.empty()) {
+        worker_args.push_back("--profile");
+        worker_args.push_back(profile_path);
+    }
+    TALauncher launcher(argv[0], worker_args);
+    
+    uint64_t start_us = ExamStats::now_us();
+    
     // Create TA processes
     vector<pid_t> ta_pids;
     for (int i = 0; i < num_tas; i++) {
-        pid_t pid = fork();
+        pid_t pid = spawn_tas ? launcher.spawn_ta(i) : fork();
         
         if (pid < 0) {
             cerr << "Error: Failed to create TA process " << i << endl;
@@ -90,12 +228,13 @@ int main(int argc, char* argv[]) {
             cout << "[TA " << i << "] Process started (PID: " << getpid() << ")" << endl;
             
             // Create TA process object and run
-            TAProcess ta(i, &shared_mem, exam_list, nullptr);
-            ta.run();
+            TAProcess ta(i, &shared_mem, nullptr);
+            ta.set_workload(&workload);
+            bool ok = ta.run();
             
             // TA finished
             cout << "[TA " << i << "] Process terminating" << endl;
-            exit(0);
+            exit(ok ? 0 : 1);
         }
         else {
             // Parent process
@@ -103,16 +242,29 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // Time to all TAs ready, includes the launch loop above
+    double launch_ms = (ExamStats::now_us() - start_us) / 1000.0;
+    double ready_ms = TALauncher::wait_until_ready(shared_mem.get_exam_stats(), num_tas, start_us, 10000);
+    cout << "[MAIN] Launched " << num_tas << " TAs with " << (spawn_tas ? "posix_spawn" : "fork")
+         << " in " << launch_ms << " ms";
+    if (ready_ms >= 0) {
+        cout << ", all ready after " << ready_ms << " ms" << endl;
+    } else {
+        cout << ", not all ready after 10 s" << endl;
+    }
+    
     // Parent waits for all TAs to complete
     cout << "[MAIN] All TA processes created, waiting for completion..." << endl << endl;
     
-    for (size_t i = 0; i < ta_pids.size(); i++) {
-        int status;
-        pid_t pid = waitpid(ta_pids[i], &status, 0);
-        if (pid > 0) {
-            cout << "[MAIN] TA process " << pid << " (TA " << i << ") terminated with status " 
-                 << WEXITSTATUS(status) << endl;
-        }
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+    int failed_tas = 0;
+    if (!wait_for_tas(ta_pids, shared_mem, failed_tas)) {
+        // TAs are gone, so the final snapshot needs no locking
+        Checkpoint::save(&shared_mem, nullptr);
+        shared_mem.cleanup();
+        cout << "\nProgress saved, run again with --resume to continue" << endl;
+        return 1;
     }
     
     cout << endl << "============================================================" << endl;
@@ -126,9 +278,22 @@ int main(int argc, char* argv[]) {
         cout << "  " << rubric->rubric_text[i] << endl;
     }
     
+    ExamStats::print_report(shared_mem.get_exam_stats());
+    if (!json_path.empty() && ExamStats::write_json(shared_mem.get_exam_stats(), json_path)) {
+        cout << "Exam latency report written to " << json_path << endl;
+    }
+    double run_seconds = (ExamStats::now_us() - start_us) / 1e6;
+    RaceDetector::print_report(&shared_mem.get_exam_stats()->races, run_seconds);
+    Results::merge(run_seconds);
+    
     // Cleanup shared memory
     shared_mem.cleanup();
+    Checkpoint::remove();
     
+    if (failed_tas > 0) {
+        cerr << "\nError: " << failed_tas << " TA(s) could not load an exam, marking is incomplete" << endl;
+        return 1;
+    }
     cout << "\nProgram completed successfully" << endl;
     return 0;
 }
\ No newline at end of file
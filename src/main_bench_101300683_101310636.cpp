@@ -0,0 +1,385 @@
+// main_bench_101300683_101310636.cpp (Microbenchmarks for the shared memory, semaphore and file I/O building blocks)
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "shared_memory.h"
+#include "semaphore_manager.h"
+#include "file_manager.h"
+
+using namespace std;
+
+const int DEFAULT_SAMPLES = 30;
+const int WARMUP_BATCHES = 3;
+const uint64_t TARGET_BATCH_NS = 2000000;   // Batches are sized to take about 2 ms
+
+// One operation under test. Contended operations are also run by several
+// forked processes at once; the others only make sense one at a time.
+struct Benchmark {
+    string name;
+    bool contended;
+    function<void()> op;
+};
+
+// Per-operation latency over all samples of one run
+struct BenchResult {
+    string name;
+    int procs;
+    int samples;            // Batches timed, over all processes
+    int batch;              // Operations per batch
+    double median_ns;
+    double p99_ns;
+    double min_ns;
+    double mean_ns;
+    double stddev_ns;
+    double ops_per_sec;     // All processes together
+};
+
+void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name << " [--samples <n>] [--procs <n,n,...>] [--filter <name>] [--json <path>]" << endl;
+    cout << "  --samples: timed batches per run (default " << DEFAULT_SAMPLES << ")" << endl;
+    cout << "  --procs: process counts for the contended runs (default 2,4,8)" << endl;
+    cout << "  --filter: only run benchmarks whose name contains this" << endl;
+    cout << "  --json: also write the results to this file" << endl;
+    cout << "  Creates and removes the same shared memory and semaphores as the marking" << endl;
+    cout << "  programs and rewrites " << FileManager::RUBRIC_FILENAME
+         << " in place, so it refuses to run while they are marking here" << endl;
+}
+
+// A marking run keeps the exam segment attached until it ends; a segment
+// nobody is attached to was left by a crashed run and may be replaced
+bool marking_run_active() {
+    key_t key = ftok(".", 'E');
+    int shm_id = (key == -1) ? -1 : shmget(key, 0, 0);
+    struct shmid_ds info;
+    return shm_id != -1 && shmctl(shm_id, IPC_STAT, &info) == 0 && info.shm_nattch > 0;
+}
+
+uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Time `samples` batches after a warmup; each sample is nanoseconds per operation
+void run_batches(const function<void()>& op, int batch, int samples, double* out, bool warmup) {
+    for (int w = 0; warmup && w < WARMUP_BATCHES; w++) {
+        for (int i = 0; i < batch; i++) {
+            op();
+        }
+    }
+    for (int s = 0; s < samples; s++) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < batch; i++) {
+            op();
+        }
+        out[s] = (double)(now_ns() - start) / batch;
+    }
+}
+
+// Double the batch until one takes TARGET_BATCH_NS, so timer overhead
+// disappears for cheap operations and slow ones still get enough samples
+int calibrate_batch(const function<void()>& op) {
+    int batch = 1;
+    while (batch < (1 << 20)) {
+        uint64_t start = now_ns();
+        for (int i = 0; i < batch; i++) {
+            op();
+        }
+        if (now_ns() - start >= TARGET_BATCH_NS) {
+            break;
+        }
+        batch *= 2;
+    }
+    return batch;
+}
+
+BenchResult summarize(const string& name, int procs, int batch, vector<double>& samples, double wall_ns) {
+    BenchResult result;
+    result.name = name;
+    result.procs = procs;
+    result.samples = samples.size();
+    result.batch = batch;
+
+    sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    result.median_ns = (n % 2 == 1) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    result.p99_ns = samples[min(n - 1, (size_t)ceil(n * 0.99) - 1)];
+    result.min_ns = samples[0];
+
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += samples[i];
+    }
+    result.mean_ns = sum / n;
+    double squares = 0;
+    for (size_t i = 0; i < n; i++) {
+        squares += (samples[i] - result.mean_ns) * (samples[i] - result.mean_ns);
+    }
+    result.stddev_ns = (n > 1) ? sqrt(squares / (n - 1)) : 0;
+    result.ops_per_sec = (double)n * batch / (wall_ns / 1e9);
+    return result;
+}
+
+BenchResult run_uncontended(const Benchmark& bench, int batch, int samples) {
+    vector<double> out(samples);
+    run_batches(bench.op, batch, samples, out.data(), true);
+
+    double busy_ns = 0;
+    for (int s = 0; s < samples; s++) {
+        busy_ns += out[s] * batch;
+    }
+    return summarize(bench.name, 1, batch, out, busy_ns);
+}
+
+// Fork `procs` processes that warm up, wait at a barrier and then all time
+// their batches at once. Samples go back through an anonymous shared mapping.
+bool run_contended(const Benchmark& bench, int batch, int samples, int procs, BenchResult& result) {
+    struct Barrier {
+        int ready;
+        int go;
+    };
+    size_t size = sizeof(Barrier) + (size_t)procs * samples * sizeof(double);
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        cerr << "Error: mmap failed for benchmark samples" << endl;
+        return false;
+    }
+    Barrier* barrier = (Barrier*)mem;
+    double* all_samples = (double*)(barrier + 1);
+    barrier->ready = 0;
+    barrier->go = 0;
+
+    vector<pid_t> pids;
+    for (int p = 0; p < procs; p++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            cerr << "Error: Failed to fork benchmark process " << p << endl;
+            barrier->go = 1;
+            for (pid_t child : pids) {
+                waitpid(child, nullptr, 0);
+            }
+            munmap(mem, size);
+            return false;
+        }
+        if (pid == 0) {
+            // CHILD PROCESS
+            for (int i = 0; i < WARMUP_BATCHES * batch; i++) {
+                bench.op();
+            }
+            __atomic_fetch_add(&barrier->ready, 1, __ATOMIC_RELEASE);
+            while (!__atomic_load_n(&barrier->go, __ATOMIC_ACQUIRE)) {
+            }
+            run_batches(bench.op, batch, samples, all_samples + (size_t)p * samples, false);
+            _exit(0);
+        }
+        pids.push_back(pid);
+    }
+
+    while (__atomic_load_n(&barrier->ready, __ATOMIC_ACQUIRE) < procs) {
+        usleep(100);
+    }
+    uint64_t start = now_ns();
+    __atomic_store_n(&barrier->go, 1, __ATOMIC_RELEASE);
+    for (pid_t child : pids) {
+        waitpid(child, nullptr, 0);
+    }
+    double wall_ns = now_ns() - start;
+
+    vector<double> merged(all_samples, all_samples + (size_t)procs * samples);
+    result = summarize(bench.name, procs, batch, merged, wall_ns);
+    munmap(mem, size);
+    return true;
+}
+
+// Contended runs always spread widely (some operations wait, some do not),
+// so only uncontended runs are flagged as noisy
+void print_result(const BenchResult& r) {
+    double cv = (r.mean_ns > 0) ? 100 * r.stddev_ns / r.mean_ns : 0;
+    cout << left << setw(22) << r.name << right << setw(6) << r.procs
+         << fixed << setprecision(1)
+         << setw(12) << r.median_ns << setw(12) << r.p99_ns << setw(12) << r.min_ns
+         << setw(8) << cv << "%"
+         << setprecision(0) << setw(14) << r.ops_per_sec
+         << (r.procs == 1 && cv > 10 ? "  (noisy)" : "") << endl;
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
+
+bool write_json(const vector<BenchResult>& results, const string& path) {
+    ofstream out(path.c_str());
+    if (!out.is_open()) {
+        cerr << "Error: Could not open " << path << " for writing" << endl;
+        return false;
+    }
+
+    out << "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "    {\"name\": \"" << r.name << "\", \"procs\": " << r.procs
+            << ", \"samples\": " << r.samples << ", \"batch\": " << r.batch
+            << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+            << ", \"min_ns\": " << r.min_ns << ", \"mean_ns\": " << r.mean_ns
+            << ", \"stddev_ns\": " << r.stddev_ns << ", \"ops_per_sec\": " << r.ops_per_sec << "}";
+    }
+    out << "\n  ]\n}\n";
+
+    out.close();
+    return !out.fail();
+}
+
+int main(int argc, char* argv[]) {
+    int samples = DEFAULT_SAMPLES;
+    vector<int> proc_counts;
+    string filter;
+    string json_path;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            samples = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--procs") == 0 && i + 1 < argc) {
+            string list = argv[++i];
+            size_t pos = 0;
+            while (pos <= list.size()) {
+                size_t comma = list.find(',', pos);
+                int count = atoi(list.substr(pos, comma - pos).c_str());
+                if (count >= 2) {
+                    proc_counts.push_back(count);
+                }
+                pos = (comma == string::npos) ? list.size() + 1 : comma + 1;
+            }
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (marking_run_active()) {
+        cerr << "Error: A marking program is running in this directory; the benchmarks would"
+             << " replace its shared memory, semaphores and rubric file" << endl;
+        return 1;
+    }
+    if (proc_counts.empty()) {
+        proc_counts.push_back(2);
+        proc_counts.push_back(4);
+        proc_counts.push_back(8);
+    }
+
+    // Benchmark an exam that exists, wherever it is stored
+    vector<int64_t> exam_list = FileManager::get_exam_list();
+    if (exam_list.empty()) {
+        cerr << "Error: No exam files found in " << FileManager::EXAM_DIR << endl;
+        return 1;
+    }
+    int64_t exam_student = exam_list[0];
+
+    // The rubric is rewritten with its own contents and restored at the end
+    char rubric[5][100];
+    if (!FileManager::read_rubric_file(rubric)) {
+        cerr << "Error: Failed to read rubric" << endl;
+        return 1;
+    }
+
+    // The library prints progress messages; keep them out of the report
+    streambuf* console = cout.rdbuf(nullptr);
+    SemaphoreManager sem_manager;
+    bool sem_ok = sem_manager.initialize();
+    cout.rdbuf(console);
+    cout.clear();
+    if (!sem_ok) {
+        cerr << "Error: Failed to initialize semaphores" << endl;
+        return 1;
+    }
+
+    int question = 0;
+    vector<Benchmark> benchmarks;
+    benchmarks.push_back({"shm_init_cleanup", false, []() {
+        SharedMemory shared_mem;
+        shared_mem.initialize();
+        shared_mem.cleanup();
+    }});
+    benchmarks.push_back({"sem_rubric_read", true, [&]() {
+        sem_manager.start_read_rubric();
+        sem_manager.end_read_rubric();
+    }});
+    benchmarks.push_back({"sem_rubric_write", true, [&]() {
+        sem_manager.start_write_rubric();
+        sem_manager.end_write_rubric();
+    }});
+    benchmarks.push_back({"sem_question_claim", true, [&]() {
+        // Cycle through the questions, like TAs looking for one to mark
+        question = (question + 1) % 5;
+        if (sem_manager.try_mark_question(question)) {
+            sem_manager.finish_mark_question(question);
+        }
+    }});
+    benchmarks.push_back({"sem_exam_load", true, [&]() {
+        sem_manager.lock_exam_load();
+        sem_manager.unlock_exam_load();
+    }});
+    benchmarks.push_back({"read_exam_file", true, [&]() {
+        int64_t student_num;
+        FileManager::read_exam_file(exam_student, student_num);
+    }});
+    benchmarks.push_back({"write_rubric_file", false, [&]() {
+        FileManager::write_rubric_file(rubric);
+    }});
+
+    cout << "Microbenchmarks: " << samples << " samples per run, median/p99/min in ns per operation" << endl;
+    cout << left << setw(22) << "benchmark" << right << setw(6) << "procs"
+         << setw(12) << "median" << setw(12) << "p99" << setw(12) << "min"
+         << setw(9) << "cv" << setw(14) << "ops/s" << endl;
+
+    vector<BenchResult> results;
+    bool ok = true;
+    for (size_t b = 0; b < benchmarks.size(); b++) {
+        const Benchmark& bench = benchmarks[b];
+        if (!filter.empty() && bench.name.find(filter) == string::npos) {
+            continue;
+        }
+
+        cout.rdbuf(nullptr);
+        int batch = calibrate_batch(bench.op);
+        BenchResult result = run_uncontended(bench, batch, samples);
+        cout.rdbuf(console);
+        cout.clear();
+        print_result(result);
+        results.push_back(result);
+
+        for (size_t p = 0; bench.contended && p < proc_counts.size(); p++) {
+            if (!run_contended(bench, batch, samples, proc_counts[p], result)) {
+                ok = false;
+                break;
+            }
+            print_result(result);
+            results.push_back(result);
+        }
+    }
+
+    FileManager::write_rubric_file(rubric);
+    cout.rdbuf(nullptr);
+    sem_manager.cleanup();
+    cout.rdbuf(console);
+    cout.clear();
+
+    if (!json_path.empty() && write_json(results, json_path)) {
+        cout << "Benchmark results written to " << json_path << endl;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// main_net_101300683_101310636.cpp (Coordinator/worker mode over sockets)
+
+#include <iostream>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <signal.h>
+#include "coordinator.h"
+#include "net_worker.h"
+
+using namespace std;
+
+void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name << " coordinator <endpoint> [--idle-timeout <seconds>]" << endl;
+    cout << "       " << program_name << " worker <endpoint> <worker_id> [batch_size]" << endl;
+    cout << "       " << program_name << " local <endpoint> <number_of_workers> [batch_size]"
+         << " [--idle-timeout <seconds>]" << endl;
+    cout << "  endpoint: unix:/path/to/socket or tcp:host:port" << endl;
+    cout << "  local: run a coordinator plus worker processes on this machine" << endl;
+    cout << "  --idle-timeout: give up when no worker was connected for this long with work"
+         << " left (default " << DEFAULT_IDLE_TIMEOUT << ")" << endl;
+}
+
+void print_rubric(RubricData* rubric) {
+    cout << "\nFinal Rubric State:" << endl;
+    for (int i = 0; i < 5; i++) {
+        cout << "  " << rubric->rubric_text[i] << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Pull out the optional flag, leaving the positional arguments in place
+    int idle_timeout = DEFAULT_IDLE_TIMEOUT;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            idle_timeout = atoi(argv[++i]);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    if (argc < 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    string mode = argv[1];
+    string endpoint = argv[2];
+
+    if (mode == "worker") {
+        if (argc < 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        int batch_size = (argc > 4) ? atoi(argv[4]) : 4;
+        NetWorker worker(atoi(argv[3]), endpoint, batch_size);
+        return worker.run() ? 0 : 1;
+    }
+
+    if (mode != "coordinator" && mode != "local") {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int num_workers = 0;
+    int batch_size = 4;
+    if (mode == "local") {
+        if (argc < 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        num_workers = atoi(argv[3]);
+        if (num_workers < 1) {
+            cerr << "Error: Number of workers must be at least 1" << endl;
+            return 1;
+        }
+        if (argc > 4) {
+            batch_size = atoi(argv[4]);
+        }
+    }
+
+    cout << "============================================================" << endl;
+    cout << "    TA Exam Marking System (Coordinator/Worker Mode)       " << endl;
+    cout << "============================================================" << endl;
+    cout << "Endpoint: " << endpoint << endl;
+    cout << "------------------------------------------------------------" << endl;
+
+    // Listen before starting local workers so they connect straight away
+    Coordinator coordinator(endpoint, idle_timeout);
+    if (!coordinator.initialize()) {
+        cerr << "Error: Failed to start coordinator" << endl;
+        return 1;
+    }
+
+    vector<pid_t> worker_pids;
+    for (int i = 0; i < num_workers; i++) {
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            cerr << "Error: Failed to create worker process " << i << endl;
+            for (pid_t p : worker_pids) {
+                kill(p, SIGTERM);
+            }
+            coordinator.cleanup();
+            return 1;
+        }
+        else if (pid == 0) {
+            // Child process - local worker
+            NetWorker worker(i, endpoint, batch_size);
+            bool ok = worker.run();
+            exit(ok ? 0 : 1);
+        }
+        else {
+            worker_pids.push_back(pid);
+        }
+    }
+
+    // Workers keep the default handlers; the coordinator reports before stopping
+    signal(SIGINT, Coordinator::request_stop);
+    signal(SIGTERM, Coordinator::request_stop);
+    bool finished = coordinator.run();
+    if (!finished) {
+        for (size_t i = 0; i < worker_pids.size(); i++) {
+            kill(worker_pids[i], SIGTERM);
+        }
+    }
+
+    for (size_t i = 0; i < worker_pids.size(); i++) {
+        int status;
+        pid_t pid = waitpid(worker_pids[i], &status, 0);
+        if (pid > 0) {
+            cout << "[MAIN] Worker process " << pid << " (worker " << i
+                 << ") terminated with status " << WEXITSTATUS(status) << endl;
+        }
+    }
+
+    print_rubric(coordinator.get_rubric_data());
+    coordinator.cleanup();
+
+    if (!finished) {
+        cerr << "Error: Marking did not finish" << endl;
+        return 1;
+    }
+    cout << "\nProgram completed successfully" << endl;
+    return 0;
+}
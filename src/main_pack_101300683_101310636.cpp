@@ -0,0 +1,92 @@
+// main_pack_101300683_101310636.cpp (Exam store maintenance: packing and sharding)
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "file_manager.h"
+
+using namespace std;
+
+void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name << " pack <name>" << endl;
+    cout << "       " << program_name << " shard" << endl;
+    cout << "  pack:  bundle every exam file into " << FileManager::EXAM_DIR << "<name>"
+         << FileManager::PACK_EXTENSION << endl;
+    cout << "  shard: move flat exam files into the hashed ab/cd/ subdirectories" << endl;
+}
+
+// Collect loose (flat or sharded) exam files. Exams already packed are left
+// out, their loose copies may be gone. Student 9999 is left out too: only a
+// flat exam_9999.txt ends a run, so moving it would change where runs stop.
+vector<int64_t> loose_exams() {
+    vector<int64_t> students;
+    vector<int64_t> exam_list = FileManager::get_exam_list();
+    for (size_t i = 0; i < exam_list.size(); i++) {
+        if (exam_list[i] != FileManager::TERMINATION_STUDENT && !FileManager::is_packed(exam_list[i])) {
+            students.push_back(exam_list[i]);
+        }
+    }
+    return students;
+}
+
+int pack_exams(const string& name) {
+    vector<int64_t> students = loose_exams();
+    string pack_path = FileManager::EXAM_DIR + name + FileManager::PACK_EXTENSION;
+    if (students.empty()) {
+        cout << "No loose exam files to pack" << endl;
+        return 0;
+    }
+    
+    // Rewriting an existing pack would drop the exams only it holds
+    struct stat info;
+    if (stat(pack_path.c_str(), &info) == 0) {
+        cerr << "Error: " << pack_path << " already exists, choose another name" << endl;
+        return 1;
+    }
+    
+    if (!FileManager::write_exam_pack(pack_path, students)) {
+        cerr << "Error: Failed to write " << pack_path << endl;
+        return 1;
+    }
+    
+    cout << "Packed " << students.size() << " exams into " << pack_path << endl;
+    cout << "The loose files can now be removed; packed copies take precedence" << endl;
+    return 0;
+}
+
+int shard_exams() {
+    vector<int64_t> students = loose_exams();
+    int moved = 0;
+    
+    for (size_t i = 0; i < students.size(); i++) {
+        string flat = FileManager::get_exam_filename(students[i]);
+        string sharded = FileManager::get_sharded_exam_filename(students[i]);
+        
+        // Create the two shard directory levels ("ab/" then "ab/cd/")
+        size_t last_slash = sharded.rfind('/');
+        size_t mid_slash = sharded.rfind('/', last_slash - 1);
+        mkdir(sharded.substr(0, mid_slash).c_str(), 0755);
+        mkdir(sharded.substr(0, last_slash).c_str(), 0755);
+        
+        if (rename(flat.c_str(), sharded.c_str()) == 0) {
+            moved++;
+        }
+    }
+    
+    cout << "Moved " << moved << " exam files into sharded directories" << endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && string(argv[1]) == "pack") {
+        return pack_exams(argv[2]);
+    }
+    if (argc == 2 && string(argv[1]) == "shard") {
+        return shard_exams();
+    }
+    
+    print_usage(argv[0]);
+    return 1;
+}
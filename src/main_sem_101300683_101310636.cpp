@@ -4,25 +4,295 @@
 #include <cstdlib>
 #include <vector>
 #include <signal.h>
+#include <cstring>
+#include <set>
+#include <map>
+#include <algorithm>
+#include <poll.h>
 #include "shared_memory.h"
 #include "file_manager.h"
 #include "ta_process.h"
 #include "semaphore_manager.h"
+#include "exam_queue.h"
+#include "file_watcher.h"
+#include "checkpoint.h"
+#include "exam_stats.h"
+#include "workload_profile.h"
+#include "results.h"
+#include "ta_launcher.h"
+#include "race_detector.h"
 
 using namespace std;
 
+volatile sig_atomic_t drain_requested = 0;
+volatile sig_atomic_t stop_requested = 0;
+
+void request_drain(int) {
+    drain_requested = 1;
+}
+
+void request_stop(int) {
+    stop_requested = 1;
+}
+
 void print_usage(const char* program_name) {
-    cout << "Usage: " << program_name << " <number_of_TAs>" << endl;
+    cout << "Usage: " << program_name << " <number_of_TAs> [--stream | --resume] [--slo <seconds>] [--json <path>]" << endl;
+    cout << "       [--profile <path>] [--spawn] [--detect-races] [--priority] [--aging <points_per_sec>]" << endl;
+    cout << "       [--active-exams <n>]" << endl;
     cout << "  number_of_TAs: must be >= 2" << endl;
+    cout << "  --stream: keep watching " << FileManager::EXAM_DIR
+         << " for new exams until SIGINT/SIGTERM drains the queue" << endl;
+    cout << "  --resume: continue from " << Checkpoint::CHECKPOINT_FILENAME << endl;
+    cout << "  --slo: flag exams whose turnaround (load to fully marked) exceeds this" << endl;
+    cout << "  --json: also write the exam latency report to this file" << endl;
+    cout << "  --profile: marking/review delays, correction rates and trace to replay" << endl;
+    cout << "  --spawn: start TAs as " << TALauncher::WORKER_BINARY << " processes with posix_spawn" << endl;
+    cout << "  --detect-races: count double claims, duplicate/skipped loads and lost rubric updates" << endl;
+    cout << "  --priority: mark exams by priority from " << FileManager::EXAM_DIR << FileManager::PRIORITY_FILENAME
+         << " (always on with --stream)" << endl;
+    cout << "  --aging: queued exams gain this much priority per second waiting" << endl;
+    cout << "  --active-exams: mark up to " << MAX_EXAM_SLOTS
+         << " exams at once, each TA sticking to one unless it runs dry" << endl;
+}
+
+// Merge instructor edits to the rubric file into shared memory while TAs run
+void reload_rubric_edits(FileWatcher& rubric_watcher, SharedMemory& shared_mem,
+                         SemaphoreManager& sem_manager) {
+    vector<string> names;
+    bool overflowed = false;
+    rubric_watcher.read_events(names, &overflowed);
+    
+    // After an overflow the rubric may have been edited without an event
+    string rubric_name = FileManager::RUBRIC_FILENAME.substr(FileManager::RUBRIC_FILENAME.rfind('/') + 1);
+    bool touched = overflowed;
+    for (size_t i = 0; i < names.size(); i++) {
+        touched = touched || names[i] == rubric_name;
+    }
+    // Most events are TAs saving their own corrections; skip those without
+    // making the next reviewers wait behind the writer lock
+    if (!touched || !shared_mem.rubric_file_edited()) {
+        return;
+    }
+    
+    // TAs save the rubric under the same lock, so a save in progress is never
+    // mistaken for an external edit
+    sem_manager.start_write_rubric();
+    int changed = shared_mem.merge_rubric_file_edits();
+    sem_manager.end_write_rubric();
+    
+    if (changed > 0) {
+        cout << "[MAIN] Reloaded " << changed << " edited rubric line(s)" << endl;
+    }
+}
+
+// Wait up to timeout_ms, handling rubric edits as they arrive
+void watch_rubric(FileWatcher& rubric_watcher, SharedMemory& shared_mem,
+                  SemaphoreManager& sem_manager, int timeout_ms) {
+    struct pollfd pfd;
+    pfd.fd = rubric_watcher.get_fd();
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, timeout_ms) > 0) {
+        reload_rubric_edits(rubric_watcher, shared_mem, sem_manager);
+    }
+}
+
+// Wait for all TAs, checkpointing the shared state every interval when
+// enabled. Returns false if SIGINT/SIGTERM interrupted the run. TAs that
+// exited with an error (an exam could not be loaded) are counted in failed_tas.
+bool wait_for_tas(const vector<pid_t>& ta_pids, SharedMemory& shared_mem,
+                  SemaphoreManager& sem_manager, FileWatcher& rubric_watcher,
+                  bool checkpointing, int& failed_tas) {
+    size_t remaining = ta_pids.size();
+    int since_checkpoint_ms = 0;
+    bool stopped = false;
+    
+    while (remaining > 0) {
+        int status;
+        pid_t pid = waitpid(-1, &status, WNOHANG);
+        if (pid > 0) {
+            for (size_t i = 0; i < ta_pids.size(); i++) {
+                if (ta_pids[i] == pid) {
+                    cout << "[MAIN] TA process " << pid << " (TA " << i 
+                         << ") terminated with status " << WEXITSTATUS(status) << endl;
+                    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                        failed_tas++;
+                    }
+                    remaining--;
+                }
+            }
+            continue;
+        }
+        
+        if (stop_requested && !stopped) {
+            cout << "[MAIN] Interrupted, stopping TAs" << endl;
+            for (pid_t p : ta_pids) {
+                kill(p, SIGTERM);
+            }
+            stopped = true;
+        }
+        
+        // A TA killed mid-save may hold the rubric lock, so stop reloading once stopping
+        if (stopped) {
+            usleep(100000); // 0.1 seconds
+        } else {
+            watch_rubric(rubric_watcher, shared_mem, sem_manager, 100);
+        }
+        since_checkpoint_ms += 100;
+        if (checkpointing && !stopped && since_checkpoint_ms >= Checkpoint::INTERVAL_MS) {
+            Checkpoint::save(&shared_mem, &sem_manager);
+            since_checkpoint_ms = 0;
+        }
+    }
+    
+    return !stopped;
+}
+
+int32_t priority_of(const map<int64_t, int32_t>& priorities, int64_t student_num) {
+    map<int64_t, int32_t>::const_iterator it = priorities.find(student_num);
+    return (it == priorities.end()) ? 0 : it->second;
+}
+
+// Queue exams that appear in the exam directory until a drain is requested.
+// Edits to the priority file reorder exams that are still waiting.
+void stream_new_exams(FileWatcher& watcher, ExamQueue& exam_queue,
+                      SemaphoreManager& sem_manager, set<int64_t>& queued,
+                      map<int64_t, int32_t>& priorities,
+                      FileWatcher& rubric_watcher, SharedMemory& shared_mem) {
+    struct pollfd pfds[2];
+    pfds[0].fd = watcher.get_fd();
+    pfds[0].events = POLLIN;
+    pfds[1].fd = rubric_watcher.get_fd();
+    pfds[1].events = POLLIN;
+    
+    while (!drain_requested) {
+        pfds[0].revents = 0;
+        pfds[1].revents = 0;
+        if (poll(pfds, 2, 500) <= 0) {
+            continue;
+        }
+        if (pfds[1].revents & POLLIN) {
+            reload_rubric_edits(rubric_watcher, shared_mem, sem_manager);
+        }
+        if (!(pfds[0].revents & POLLIN)) {
+            continue;
+        }
+        
+        vector<string> names;
+        bool overflowed = false;
+        watcher.read_events(names, &overflowed);
+        
+        // Events were dropped: rescan the directory, the queued set filters
+        // out every exam already seen
+        vector<int64_t> new_exams;
+        bool priorities_changed = overflowed;
+        if (overflowed) {
+            cout << "[MAIN] Missed exam directory events, rescanning " << FileManager::EXAM_DIR << endl;
+            new_exams = FileManager::get_exam_list();
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            int64_t student_num;
+            if (names[i] == FileManager::PRIORITY_FILENAME) {
+                priorities_changed = true;
+            } else if (FileManager::parse_exam_filename(names[i], student_num)) {
+                new_exams.push_back(student_num);
+            }
+        }
+        
+        if (priorities_changed) {
+            FileManager::read_priorities(priorities);
+            sem_manager.lock_exam_load();
+            int changed = exam_queue.update_priorities(priorities);
+            sem_manager.unlock_exam_load();
+            cout << "[MAIN] Reloaded priorities, " << changed << " queued exam(s) reordered" << endl;
+        }
+        
+        for (size_t i = 0; i < new_exams.size(); i++) {
+            int64_t student_num = new_exams[i];
+            if (!queued.insert(student_num).second) {
+                continue;
+            }
+            
+            sem_manager.lock_exam_load();
+            int32_t priority = priority_of(priorities, student_num);
+            bool pushed = exam_queue.push(student_num, priority);
+            sem_manager.unlock_exam_load();
+            
+            if (pushed) {
+                cout << "[MAIN] Queued new exam for student " << student_num
+                     << " (priority " << priority << ")" << endl;
+            } else {
+                cerr << "[MAIN] Exam queue full, dropping student " << student_num << endl;
+                queued.erase(student_num);
+            }
+        }
+    }
+    
+    sem_manager.lock_exam_load();
+    exam_queue.set_draining();
+    sem_manager.unlock_exam_load();
+    cout << "[MAIN] Drain requested, finishing " << exam_queue.size() << " queued exams" << endl;
 }
 
 int main(int argc, char* argv[]) {
     // Parse arguments 
-    if (argc != 2) {
+    if (argc < 2) {
         print_usage(argv[0]);
         return 1;
     }
     
+    bool stream_mode = false;
+    bool resume = false;
+    double slo_seconds = 0;
+    string json_path;
+    string profile_path;
+    bool spawn_tas = false;
+    bool detect_races = false;
+    bool priority_mode = false;
+    double aging_rate = 0;
+    int active_exams = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--stream") == 0) {
+            stream_mode = true;
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            resume = true;
+        } else if (strcmp(argv[i], "--slo") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) {
+            slo_seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (strcmp(argv[i], "--spawn") == 0) {
+            spawn_tas = true;
+        } else if (strcmp(argv[i], "--detect-races") == 0) {
+            detect_races = true;
+        } else if (strcmp(argv[i], "--priority") == 0) {
+            priority_mode = true;
+        } else if (strcmp(argv[i], "--aging") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0) {
+            aging_rate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--active-exams") == 0 && i + 1 < argc &&
+                   atoi(argv[i + 1]) >= 1 && atoi(argv[i + 1]) <= MAX_EXAM_SLOTS) {
+            active_exams = atoi(argv[++i]);
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    
+    // The streaming queue is not part of the checkpoint
+    if ((stream_mode || priority_mode) && resume) {
+        cerr << "Error: --resume cannot be combined with --stream or --priority" << endl;
+        return 1;
+    }
+    // Both take exams from the shared queue instead of the exam list
+    bool queue_mode = stream_mode || priority_mode;
+    
+    // Slots are refilled from the exam list; a checkpoint holds one exam
+    if (active_exams > 1 && (queue_mode || resume)) {
+        cerr << "Error: --active-exams cannot be combined with --stream, --priority or --resume" << endl;
+        return 1;
+    }
+    
     int num_tas = atoi(argv[1]);
     if (num_tas < 2) {
         cerr << "Error: Number of TAs must be at least 2" << endl;
@@ -34,18 +304,39 @@ int main(int argc, char* argv[]) {
     cout << "    TA Exam Marking System (Part B - With Semaphores)      " << endl;
     cout << "============================================================" << endl;
     cout << "Number of TAs: " << num_tas << endl;
+    if (stream_mode) {
+        cout << "Mode: streaming (exams are picked up as they arrive)" << endl;
+    } else if (priority_mode) {
+        cout << "Mode: priority (highest priority exams are marked first)" << endl;
+    }
+    if (active_exams > 1) {
+        cout << "Active exams: " << active_exams << " (TA i works on exam slot i mod "
+             << active_exams << " first)" << endl;
+    }
+    if (queue_mode && aging_rate > 0) {
+        cout << "Aging: +" << aging_rate << " priority per second waiting" << endl;
+    }
+    
+    WorkloadProfile workload;
+    if (!profile_path.empty()) {
+        if (!workload.load(profile_path)) {
+            return 1;
+        }
+        workload.print_summary();
+    }
     cout << "------------------------------------------------------------" << endl;
     
     // Initialize shared memory 
     SharedMemory shared_mem;
-    if (!shared_mem.initialize()) {
+    if (!shared_mem.initialize(active_exams)) {
         cerr << "Error: Failed to initialize shared memory" << endl;
         return 1;
     }
+    shared_mem.get_exam_stats()->slo_us = (uint64_t)(slo_seconds * 1000000);
     
     // Initialize semaphore manager
     SemaphoreManager sem_manager;
-    if (!sem_manager.initialize()) {
+    if (!sem_manager.initialize(active_exams)) {
         cerr << "Error: Failed to initialize semaphores" << endl;
         shared_mem.cleanup();
         return 1;
@@ -59,36 +350,187 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    vector<int> exam_list = FileManager::get_exam_list();
-    if (exam_list.empty()) {
+    // Streaming mode watches the directory before scanning it so no exam is missed
+    ExamQueue exam_queue;
+    FileWatcher exam_watcher;
+    set<int64_t> queued;
+    if (stream_mode) {
+        if (!exam_queue.initialize(MAX_QUEUED_EXAMS, aging_rate) ||
+            !exam_watcher.initialize(FileManager::EXAM_DIR)) {
+            cerr << "Error: Failed to set up exam streaming" << endl;
+            exam_queue.cleanup();
+            sem_manager.cleanup();
+            shared_mem.cleanup();
+            return 1;
+        }
+    }
+    
+    vector<int64_t> exam_list = FileManager::get_exam_list();
+    map<int64_t, int32_t> priorities;
+    FileManager::read_priorities(priorities);
+    if (stream_mode) {
+        for (size_t i = 0; i < exam_list.size(); i++) {
+            if (queued.insert(exam_list[i]).second) {
+                exam_queue.push(exam_list[i], priority_of(priorities, exam_list[i]));
+            }
+        }
+        
+        cout << "Queued " << exam_queue.size() << " exam files" << endl;
+        
+        // TAs take exams from the queue; the list only tells them where the
+        // packed ones are stored
+        if (!shared_mem.publish_exam_list(exam_list)) {
+            cerr << "Error: Failed to share exam list" << endl;
+            exam_queue.cleanup();
+            sem_manager.cleanup();
+            shared_mem.cleanup();
+            return 1;
+        }
+    }
+    else if (exam_list.empty()) {
         cerr << "Error: No exam files found in " << FileManager::EXAM_DIR << endl;
         sem_manager.cleanup();
         shared_mem.cleanup();
         return 1;
     }
+    else {
+        cout << "Found " << exam_list.size() << " exam files" << endl;
+        
+        // Share one read-only copy of the list with every TA
+        if (!shared_mem.publish_exam_list(exam_list)) {
+            cerr << "Error: Failed to share exam list" << endl;
+            sem_manager.cleanup();
+            shared_mem.cleanup();
+            return 1;
+        }
+        
+        if (priority_mode) {
+            // The queue holds every exam up front; TAs stop once it is empty
+            if (!exam_queue.initialize(shared_mem.get_exam_count(), aging_rate)) {
+                cerr << "Error: Failed to create exam queue" << endl;
+                sem_manager.cleanup();
+                shared_mem.cleanup();
+                return 1;
+            }
+            for (int64_t i = 0; i < shared_mem.get_exam_count(); i++) {
+                const ExamListEntry* entry = shared_mem.get_exam_entry(i);
+                if (!FileManager::is_termination_exam(entry->student_number)) {
+                    exam_queue.push(entry->student_number, entry->priority);
+                }
+            }
+            exam_queue.set_draining();
+            
+            cout << "Queued " << exam_queue.size() << " exams by priority ("
+                 << priorities.size() << " listed in " << FileManager::PRIORITY_FILENAME << ")" << endl;
+        } else if (resume) {
+            // Pick up where the last checkpoint left off
+            CheckpointData saved;
+            if (!Checkpoint::load(saved) || !Checkpoint::restore(saved, &shared_mem)) {
+                cerr << "Error: Failed to resume from checkpoint" << endl;
+                sem_manager.cleanup();
+                shared_mem.cleanup();
+                return 1;
+            }
+        } else if (active_exams > 1) {
+            // Fill each slot with the next exam; slots left over start drained
+            for (int slot = 0; slot < active_exams; slot++) {
+                int64_t student = slot < shared_mem.get_exam_count() ?
+                                  shared_mem.get_exam_entry(slot)->student_number : -1;
+                if (student == -1 || FileManager::is_termination_exam(student)) {
+                    ExamData* exam = shared_mem.get_exam_data(slot);
+                    exam->current_exam_index = -1;
+                    exam->all_marked = true;
+                } else if (!shared_mem.load_exam_from_file(student, slot, slot)) {
+                    cerr << "Error: Failed to load exam for student " << student << endl;
+                    sem_manager.cleanup();
+                    shared_mem.cleanup();
+                    return 1;
+                }
+            }
+            
+            cout << "Starting marking process with " << active_exams << " active exams" << endl;
+        } else {
+            int64_t first_student = shared_mem.get_exam_entry(0)->student_number;
+            if (!shared_mem.load_exam_from_file(first_student, 0)) {
+                cerr << "Error: Failed to load first exam" << endl;
+                sem_manager.cleanup();
+                shared_mem.cleanup();
+                return 1;
+            }
+            
+            cout << "Starting marking process with student " << first_student << endl;
+        }
+    }
+    vector<int64_t>().swap(exam_list);
     
-    cout << "Found " << exam_list.size() << " exam files" << endl;
+    if (queue_mode) {
+        // No exam is loaded yet, the first TA pulls one from the queue
+        ExamData* exam = shared_mem.get_exam_data();
+        exam->student_number = -1;
+        exam->current_exam_index = -1;
+        exam->all_marked = true;
+    }
     
-    if (!shared_mem.load_exam_from_file(exam_list[0], 0)) {
-        cerr << "Error: Failed to load first exam" << endl;
+    cout << "============================================================" << endl << endl;
+    
+    // Each TA appends to its own part file, merged once marking is done
+    if (!Results::prepare(resume)) {
+        exam_queue.cleanup();
         sem_manager.cleanup();
         shared_mem.cleanup();
         return 1;
     }
     
-    cout << "Starting marking process with student " << exam_list[0] << endl;
-    cout << "============================================================" << endl << endl;
+    // Instructors may edit the rubric file while TAs run
+    FileWatcher rubric_watcher;
+    string rubric_dir = FileManager::RUBRIC_FILENAME.substr(0, FileManager::RUBRIC_FILENAME.rfind('/') + 1);
+    if (!rubric_watcher.initialize(rubric_dir)) {
+        cerr << "Error: Failed to watch " << FileManager::RUBRIC_FILENAME << endl;
+        exam_queue.cleanup();
+        sem_manager.cleanup();
+        shared_mem.cleanup();
+        return 1;
+    }
+    shared_mem.get_rubric_data()->watch_edits = true;
+    if (detect_races) {
+        int first_index = -1;
+        for (int slot = 0; slot < active_exams; slot++) {
+            first_index = max(first_index, shared_mem.get_exam_data(slot)->current_exam_index);
+        }
+        RaceDetector::start(&shared_mem.get_exam_stats()->races, first_index);
+    }
+    
+    // Spawned workers get the same options as forked TAs
+    vector<string> worker_args;
+    worker_args.push_back("--sem");
+    if (stream_mode) {
+        worker_args.push_back("--stream");
+    } else if (priority_mode) {
+        worker_args.push_back("--queue");
+    }
+    if (active_exams > 1) {
+        worker_args.push_back("--slots");
+        worker_args.push_back(to_string(active_exams));
+    }
+    if (!profile_path.empty()) {
+        worker_args.push_back("--profile");
+        worker_args.push_back(profile_path);
+    }
+    TALauncher launcher(argv[0], worker_args);
+    
+    uint64_t start_us = ExamStats::now_us();
     
     // Create TA processes (updated to pass semaphore manager)
     vector<pid_t> ta_pids;
     for (int i = 0; i < num_tas; i++) {
-        pid_t pid = fork();
+        pid_t pid = spawn_tas ? launcher.spawn_ta(i) : fork();
         
         if (pid < 0) {
             cerr << "Error: Failed to create TA process " << i << endl;
             for (pid_t p : ta_pids) {
                 kill(p, SIGTERM);
             }
+            exam_queue.cleanup();
             sem_manager.cleanup();
             shared_mem.cleanup();
             return 1;
@@ -98,11 +540,19 @@ int main(int argc, char* argv[]) {
             cout << "[TA " << i << "] Process started (PID: " << getpid() << ")" << endl;
             
             // Create TA with semaphore manager 
-            TAProcess ta(i, &shared_mem, exam_list, &sem_manager);
-            ta.run();
+            TAProcess ta(i, &shared_mem, &sem_manager);
+            ta.set_workload(&workload);
+            if (stream_mode) {
+                // Ctrl-C drains through the main process instead of killing TAs
+                signal(SIGINT, SIG_IGN);
+            }
+            if (queue_mode) {
+                ta.set_exam_queue(&exam_queue);
+            }
+            bool ok = ta.run();
             
             cout << "[TA " << i << "] Process terminating" << endl;
-            exit(0);
+            exit(ok ? 0 : 1);
         }
         else {
             // PARENT PROCESS
@@ -110,18 +560,53 @@ int main(int argc, char* argv[]) {
         }
     }
     
+    // Time to all TAs ready, includes the launch loop above
+    double launch_ms = (ExamStats::now_us() - start_us) / 1000.0;
+    double ready_ms = TALauncher::wait_until_ready(shared_mem.get_exam_stats(), num_tas, start_us, 10000);
+    cout << "[MAIN] Launched " << num_tas << " TAs with " << (spawn_tas ? "posix_spawn" : "fork")
+         << " in " << launch_ms << " ms";
+    if (ready_ms >= 0) {
+        cout << ", all ready after " << ready_ms << " ms" << endl;
+    } else {
+        cout << ", not all ready after 10 s" << endl;
+    }
+    
     // Wait for all children 
     cout << "[MAIN] All TA processes created, waiting for completion..." << endl << endl;
     
-    for (size_t i = 0; i < ta_pids.size(); i++) {
-        int status;
-        pid_t pid = waitpid(ta_pids[i], &status, 0);
-        if (pid > 0) {
-            cout << "[MAIN] TA process " << pid << " (TA " << i 
-                 << ") terminated with status " << WEXITSTATUS(status) << endl;
+    int failed_tas = 0;
+    if (stream_mode) {
+        signal(SIGINT, request_drain);
+        signal(SIGTERM, request_drain);
+        cout << "[MAIN] Watching " << FileManager::EXAM_DIR
+             << " for new exams (SIGINT or SIGTERM to drain)" << endl << endl;
+        stream_new_exams(exam_watcher, exam_queue, sem_manager, queued, priorities, rubric_watcher, shared_mem);
+        exam_watcher.cleanup();
+        wait_for_tas(ta_pids, shared_mem, sem_manager, rubric_watcher, false, failed_tas);
+    }
+    else {
+        signal(SIGINT, request_stop);
+        signal(SIGTERM, request_stop);
+        bool checkpointing = !priority_mode && active_exams == 1;
+        if (!wait_for_tas(ta_pids, shared_mem, sem_manager, rubric_watcher, checkpointing, failed_tas)) {
+            if (!checkpointing) {
+                exam_queue.cleanup();
+                sem_manager.cleanup();
+                shared_mem.cleanup();
+                cout << "\nInterrupted, priority and multi-exam runs are not checkpointed" << endl;
+                return 1;
+            }
+            // A killed TA may still hold a semaphore, snapshot without locking
+            Checkpoint::save(&shared_mem, nullptr);
+            sem_manager.cleanup();
+            shared_mem.cleanup();
+            cout << "\nProgress saved, run again with --resume to continue" << endl;
+            return 1;
         }
     }
     
+    rubric_watcher.cleanup();
+    
     cout << endl << "============================================================" << endl;
     cout << "         All TAs have finished marking exams                " << endl;
     cout << "============================================================" << endl;
@@ -133,10 +618,28 @@ int main(int argc, char* argv[]) {
         cout << "  " << rubric->rubric_text[i] << endl;
     }
     
+    ExamStats::print_report(shared_mem.get_exam_stats());
+    if (!json_path.empty() && ExamStats::write_json(shared_mem.get_exam_stats(), json_path)) {
+        cout << "Exam latency report written to " << json_path << endl;
+    }
+    double run_seconds = (ExamStats::now_us() - start_us) / 1e6;
+    RaceDetector::print_report(&shared_mem.get_exam_stats()->races, run_seconds);
+    Results::merge(run_seconds);
+    
+    sem_manager.print_lock_stats();
+    
     // Cleanup 
+    exam_queue.cleanup();
     sem_manager.cleanup();
     shared_mem.cleanup();
+    if (!queue_mode) {
+        Checkpoint::remove();
+    }
     
+    if (failed_tas > 0) {
+        cerr << "\nError: " << failed_tas << " TA(s) could not load an exam, marking is incomplete" << endl;
+        return 1;
+    }
     cout << "\nProgram completed successfully" << endl;
     return 0;
 }
\ No newline at end of file
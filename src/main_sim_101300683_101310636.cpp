@@ -0,0 +1,304 @@
+// main_sim_101300683_101310636.cpp (Coroutine simulation of many TAs in one process)
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "shared_memory.h"
+#include "file_manager.h"
+#include "ta_process.h"
+#include "sim_engine.h"
+#include "workload_profile.h"
+
+using namespace std;
+
+void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name << " <number_of_TAs> [threads] [time_scale] [--profile <path>]" << endl;
+    cout << "  number_of_TAs: must be >= 2" << endl;
+    cout << "  threads: executor threads (default: number of CPUs)" << endl;
+    cout << "  time_scale: real seconds per simulated second (default: 0.01)" << endl;
+    cout << "  --profile: marking/review delays, correction rates and trace to replay" << endl;
+}
+
+// State shared by all simulated TAs; the rubric file is never written
+struct SimState {
+    vector<int64_t> exam_list;
+    ExamData exam;
+    RubricData rubric;
+    mutex exam_mutex;       // Stands in for the question and exam-load semaphores
+    bool load_failed;       // An exam could not be read, the run is incomplete
+    AsyncRWLock rubric_lock;
+    WorkloadProfile workload;
+
+    mutex stats_mutex;
+    uint64_t questions_marked;
+    uint64_t exams_completed;
+    uint64_t corrections;
+    uint64_t idle_waits;
+
+    explicit SimState(SimEngine* engine)
+        : load_failed(false), rubric_lock(engine), questions_marked(0), exams_completed(0),
+          corrections(0), idle_waits(0) {
+        memset(&exam, 0, sizeof(exam));
+        memset(&rubric, 0, sizeof(rubric));
+    }
+};
+
+// Same fields as SharedMemory::load_exam_from_file. Called with exam_mutex held.
+bool load_exam(SimState& state, int exam_index) {
+    int64_t student_num;
+    if (!FileManager::read_exam_file(state.exam_list[exam_index], student_num)) {
+        return false;
+    }
+
+    ExamData& exam = state.exam;
+    exam.student_number = student_num;
+    for (int i = 0; i < 5; i++) {
+        exam.questions_marked[i] = false;
+        exam.questions_being_marked[i] = -1;
+    }
+    exam.all_marked = false;
+    exam.current_exam_index = exam_index;
+    exam.is_termination = FileManager::is_termination_exam(student_num);
+    return true;
+}
+
+// Load the next exam unless another TA already did. False when the list is
+// done or an exam could not be read, which stops every TA.
+bool load_next_exam(SimState& state) {
+    lock_guard<mutex> guard(state.exam_mutex);
+    if (state.load_failed) {
+        return false;
+    }
+    if (!state.exam.all_marked) {
+        return true;
+    }
+
+    int next = state.exam.current_exam_index + 1;
+    if (next >= (int)state.exam_list.size()) {
+        return false;
+    }
+    if (!load_exam(state, next)) {
+        cerr << "Error: Failed to load exam for student " << state.exam_list[next] << endl;
+        state.load_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool exam_finished(SimState& state, bool& terminated) {
+    lock_guard<mutex> guard(state.exam_mutex);
+    terminated = state.exam.is_termination;
+    return state.exam.all_marked;
+}
+
+// Returns the claimed question (or -1) and the student it belongs to
+int claim_next_question(SimState& state, int ta_id, int64_t& student_number) {
+    lock_guard<mutex> guard(state.exam_mutex);
+    student_number = state.exam.student_number;
+    if (state.exam.all_marked) {
+        return -1;
+    }
+    for (int q = 0; q < 5; q++) {
+        if (TAProcess::claim_question(&state.exam, q, ta_id)) {
+            return q;
+        }
+    }
+    return -1;
+}
+
+void finish_question(SimState& state, int question, int64_t student_number) {
+    bool exam_done = false;
+    {
+        lock_guard<mutex> guard(state.exam_mutex);
+        if (state.exam.student_number == student_number) {
+            exam_done = TAProcess::complete_question(&state.exam, question);
+        }
+    }
+
+    lock_guard<mutex> guard(state.stats_mutex);
+    state.questions_marked++;
+    if (exam_done) {
+        state.exams_completed++;
+    }
+}
+
+void count_stat(SimState& state, uint64_t& counter) {
+    lock_guard<mutex> guard(state.stats_mutex);
+    counter++;
+}
+
+// One TA, following the same steps and delays as TAProcess::run()
+SimTask simulate_ta(SimEngine& engine, SimState& state, int ta_id, unsigned seed) {
+    mt19937 rng(seed);
+    const WorkloadProfile& workload = state.workload;
+
+    while (true) {
+        bool terminated;
+        bool all_marked = exam_finished(state, terminated);
+        if (terminated) {
+            break;
+        }
+
+        if (all_marked) {
+            co_await engine.sleep_for(0.1);
+            if (!load_next_exam(state)) {
+                break;
+            }
+            exam_finished(state, terminated);
+            if (terminated) {
+                break;
+            }
+        }
+
+        // Review each rubric line, correcting some of them
+        for (int q = 0; q < 5; q++) {
+            co_await state.rubric_lock.lock_shared();
+            co_await engine.sleep_for(workload.review_time(q, rng));
+            bool needs_correction = workload.needs_correction(q, rng);
+            state.rubric_lock.unlock_shared();
+
+            if (needs_correction) {
+                co_await state.rubric_lock.lock();
+                char from, to;
+                bool changed = TAProcess::correct_rubric_line(&state.rubric, q, from, to);
+                state.rubric_lock.unlock();
+                if (changed) {
+                    count_stat(state, state.corrections);
+                }
+            }
+        }
+
+        int64_t student_number;
+        int question = claim_next_question(state, ta_id, student_number);
+        if (question != -1) {
+            co_await engine.sleep_for(workload.mark_time(question, student_number, rng));
+            finish_question(state, question, student_number);
+        } else {
+            count_stat(state, state.idle_waits);
+            co_await engine.sleep_for(0.2);
+        }
+    }
+}
+
+void print_wait_stats(const char* name, const LockWaitStats& stats) {
+    double mean = stats.waits > 0 ? stats.total_wait / stats.waits : 0.0;
+    cout << "  " << name << ": " << stats.acquisitions << " acquisitions, "
+         << stats.waits << " waited, mean wait " << mean << " s, max wait "
+         << stats.max_wait << " s" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    // Positional arguments first, then options
+    vector<const char*> positional;
+    string profile_path;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else if (argv[i][0] == '-') {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+    if (positional.empty() || positional.size() > 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int num_tas = atoi(positional[0]);
+    if (num_tas < 2) {
+        cerr << "Error: Number of TAs must be at least 2" << endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int num_threads = (positional.size() > 1) ? atoi(positional[1]) : (int)thread::hardware_concurrency();
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    double time_scale = (positional.size() > 2) ? atof(positional[2]) : 0.01;
+    if (time_scale <= 0) {
+        cerr << "Error: time_scale must be positive" << endl;
+        return 1;
+    }
+
+    cout << "============================================================" << endl;
+    cout << "    TA Exam Marking System (Coroutine Simulation)          " << endl;
+    cout << "============================================================" << endl;
+    cout << "Number of TAs: " << num_tas << endl;
+    cout << "Executor threads: " << num_threads << endl;
+    cout << "Time scale: " << time_scale << " real s per simulated s" << endl;
+
+    SimEngine engine(num_threads, time_scale);
+    SimState state(&engine);
+    if (!profile_path.empty()) {
+        if (!state.workload.load(profile_path)) {
+            return 1;
+        }
+        state.workload.print_summary();
+    }
+    cout << "------------------------------------------------------------" << endl;
+
+    if (!FileManager::read_rubric_file(state.rubric.rubric_text)) {
+        cerr << "Error: Failed to load rubric" << endl;
+        return 1;
+    }
+
+    state.exam_list = FileManager::get_exam_list();
+    if (state.exam_list.empty()) {
+        cerr << "Error: No exam files found in " << FileManager::EXAM_DIR << endl;
+        return 1;
+    }
+    cout << "Found " << state.exam_list.size() << " exam files" << endl;
+
+    if (!load_exam(state, 0)) {
+        cerr << "Error: Failed to load first exam" << endl;
+        return 1;
+    }
+    cout << "Starting marking process with student " << state.exam.student_number << endl;
+    cout << "============================================================" << endl << endl;
+
+    for (int i = 0; i < num_tas; i++) {
+        engine.spawn(simulate_ta(engine, state, i, (unsigned)time(nullptr) + i));
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    engine.run();
+    chrono::duration<double> real_time = chrono::steady_clock::now() - start;
+
+    cout << "============================================================" << endl;
+    cout << "         All simulated TAs have finished                    " << endl;
+    cout << "============================================================" << endl;
+    cout << fixed << setprecision(3);
+    cout << "Simulated time: " << engine.now() << " s" << endl;
+    cout << "Real time: " << real_time.count() << " s" << endl;
+    cout << "Exams completed: " << state.exams_completed << endl;
+    cout << "Questions marked: " << state.questions_marked << endl;
+    cout << "Rubric corrections: " << state.corrections << endl;
+    cout << "Idle waits (no question available): " << state.idle_waits << endl;
+    cout << "Coroutine resumes: " << engine.get_resumes() << endl;
+
+    cout << "\nRubric lock (simulated seconds):" << endl;
+    print_wait_stats("readers", state.rubric_lock.get_read_stats());
+    print_wait_stats("writers", state.rubric_lock.get_write_stats());
+
+    // Display final rubric
+    cout << "\nFinal Rubric State:" << endl;
+    for (int i = 0; i < 5; i++) {
+        cout << "  " << state.rubric.rubric_text[i] << endl;
+    }
+
+    if (state.load_failed) {
+        cerr << "\nSimulation stopped early: an exam could not be loaded" << endl;
+        return 1;
+    }
+    cout << "\nSimulation completed successfully" << endl;
+    return 0;
+}
@@ -0,0 +1,84 @@
+// main_ta_101300683_101310636.cpp (One TA, started by the Part A/B mains with --spawn)
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <signal.h>
+#include <unistd.h>
+#include "shared_memory.h"
+#include "semaphore_manager.h"
+#include "exam_queue.h"
+#include "ta_process.h"
+#include "workload_profile.h"
+
+using namespace std;
+
+void print_usage(const char* program_name) {
+    cout << "Usage: " << program_name << " <ta_id> [--sem] [--stream | --queue] [--slots <n>] [--profile <path>]" << endl;
+    cout << "  Started by main_101300683_101310636 / main_sem_101300683_101310636 --spawn;" << endl;
+    cout << "  attaches to the shared memory and semaphores they created" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int ta_id = atoi(argv[1]);
+    bool use_semaphores = false;
+    bool stream_mode = false;
+    bool queue_mode = false;    // Priority mode: take exams from the queue, no drain
+    int exam_slots = 1;         // --active-exams of the main process
+    string profile_path;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--sem") == 0) {
+            use_semaphores = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream_mode = true;
+            queue_mode = true;
+        } else if (strcmp(argv[i], "--queue") == 0) {
+            queue_mode = true;
+        } else if (strcmp(argv[i], "--slots") == 0 && i + 1 < argc &&
+                   atoi(argv[i + 1]) >= 1 && atoi(argv[i + 1]) <= MAX_EXAM_SLOTS) {
+            exam_slots = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    SharedMemory shared_mem;
+    SemaphoreManager sem_manager;
+    ExamQueue exam_queue;
+    if (!shared_mem.attach(exam_slots) ||
+        (use_semaphores && !sem_manager.attach(exam_slots)) ||
+        (queue_mode && !exam_queue.attach())) {
+        cerr << "[TA " << ta_id << "] Error: Main process state not found" << endl;
+        return 1;
+    }
+
+    WorkloadProfile workload;
+    if (!profile_path.empty() && !workload.load(profile_path)) {
+        return 1;
+    }
+
+    cout << "[TA " << ta_id << "] Process started (PID: " << getpid() << ")" << endl;
+
+    TAProcess ta(ta_id, &shared_mem, use_semaphores ? &sem_manager : nullptr);
+    ta.set_workload(&workload);
+    if (stream_mode) {
+        // Ctrl-C drains through the main process instead of killing TAs
+        signal(SIGINT, SIG_IGN);
+    }
+    if (queue_mode) {
+        ta.set_exam_queue(&exam_queue);
+    }
+    bool ok = ta.run();
+
+    cout << "[TA " << ta_id << "] Process terminating" << endl;
+    return ok ? 0 : 1;
+}
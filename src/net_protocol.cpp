@@ -0,0 +1,399 @@
+// net_protocol.cpp
+// Framing, payload encoding and socket setup for coordinator/worker mode
+
+#include "net_protocol.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+const uint32_t NetProtocol::MAX_PAYLOAD = 1 << 20;
+const int NetProtocol::MAX_LEASE_ITEMS = 256;
+
+static const size_t HEADER_SIZE = 5;
+
+void PayloadWriter::put_u8(uint8_t value) {
+    data.push_back(value);
+}
+
+void PayloadWriter::put_u16(uint16_t value) {
+    data.push_back((value >> 8) & 0xFF);
+    data.push_back(value & 0xFF);
+}
+
+void PayloadWriter::put_u32(uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data.push_back((value >> shift) & 0xFF);
+    }
+}
+
+void PayloadWriter::put_i64(int64_t value) {
+    uint64_t raw = (uint64_t)value;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        data.push_back((raw >> shift) & 0xFF);
+    }
+}
+
+void PayloadWriter::put_string(const std::string& value) {
+    size_t len = value.length() > 255 ? 255 : value.length();
+    put_u8((uint8_t)len);
+    data.insert(data.end(), value.begin(), value.begin() + len);
+}
+
+Message PayloadWriter::to_message(uint8_t type) const {
+    Message msg;
+    msg.type = type;
+    msg.payload = data;
+    return msg;
+}
+
+PayloadReader::PayloadReader(const std::vector<uint8_t>& payload)
+    : data(payload), pos(0), valid(true) {
+}
+
+bool PayloadReader::need(size_t bytes) {
+    if (!valid || pos + bytes > data.size()) {
+        valid = false;
+        return false;
+    }
+    return true;
+}
+
+uint8_t PayloadReader::get_u8() {
+    if (!need(1)) {
+        return 0;
+    }
+    return data[pos++];
+}
+
+uint16_t PayloadReader::get_u16() {
+    if (!need(2)) {
+        return 0;
+    }
+    uint16_t value = (uint16_t)((data[pos] << 8) | data[pos + 1]);
+    pos += 2;
+    return value;
+}
+
+uint32_t PayloadReader::get_u32() {
+    if (!need(4)) {
+        return 0;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value = (value << 8) | data[pos++];
+    }
+    return value;
+}
+
+int64_t PayloadReader::get_i64() {
+    if (!need(8)) {
+        return 0;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | data[pos++];
+    }
+    return (int64_t)value;
+}
+
+std::string PayloadReader::get_string() {
+    uint8_t len = get_u8();
+    if (!need(len)) {
+        return "";
+    }
+    std::string value(data.begin() + pos, data.begin() + pos + len);
+    pos += len;
+    return value;
+}
+
+bool PayloadReader::ok() const {
+    return valid;
+}
+
+Connection::Connection(int socket_fd) : fd(socket_fd) {
+}
+
+Connection::~Connection() {
+    close_connection();
+}
+
+int Connection::get_fd() const {
+    return fd;
+}
+
+bool Connection::set_nonblocking() {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+void Connection::queue(const Message& msg) {
+    uint32_t len = (uint32_t)msg.payload.size();
+    out_buf.push_back(msg.type);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out_buf.push_back((len >> shift) & 0xFF);
+    }
+    out_buf.insert(out_buf.end(), msg.payload.begin(), msg.payload.end());
+}
+
+bool Connection::flush() {
+    size_t sent = 0;
+    while (sent < out_buf.size()) {
+        ssize_t n = send(fd, out_buf.data() + sent, out_buf.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            out_buf.clear();
+            return false;
+        }
+        sent += n;
+    }
+    out_buf.clear();
+    return true;
+}
+
+bool Connection::send_available() {
+    size_t sent = 0;
+    while (sent < out_buf.size()) {
+        ssize_t n = send(fd, out_buf.data() + sent, out_buf.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;  // Socket buffer full, the rest goes out on the next POLLOUT
+            }
+            out_buf.clear();
+            return false;
+        }
+        sent += n;
+    }
+    out_buf.erase(out_buf.begin(), out_buf.begin() + sent);
+    return true;
+}
+
+bool Connection::has_output() const {
+    return !out_buf.empty();
+}
+
+bool Connection::read_available() {
+    uint8_t chunk[4096];
+    ssize_t n;
+    do {
+        n = recv(fd, chunk, sizeof(chunk), 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;  // Non-blocking socket with nothing to read yet
+    }
+    if (n <= 0) {
+        return false;
+    }
+    in_buf.insert(in_buf.end(), chunk, chunk + n);
+    return true;
+}
+
+bool Connection::next_message(Message& msg) {
+    if (in_buf.size() < HEADER_SIZE) {
+        return false;
+    }
+
+    uint32_t len = 0;
+    for (int i = 1; i <= 4; i++) {
+        len = (len << 8) | in_buf[i];
+    }
+    // Never buffer towards a frame the peer has no business sending
+    if (len > NetProtocol::MAX_PAYLOAD) {
+        std::cerr << "[NET] Error: frame of " << len << " bytes exceeds the "
+                  << NetProtocol::MAX_PAYLOAD << " byte limit, closing connection" << std::endl;
+        in_buf.clear();
+        close_connection();
+        return false;
+    }
+    if (in_buf.size() < HEADER_SIZE + len) {
+        return false;
+    }
+
+    msg.type = in_buf[0];
+    msg.payload.assign(in_buf.begin() + HEADER_SIZE, in_buf.begin() + HEADER_SIZE + len);
+    in_buf.erase(in_buf.begin(), in_buf.begin() + HEADER_SIZE + len);
+    return true;
+}
+
+bool Connection::is_open() const {
+    return fd != -1;
+}
+
+void Connection::close_connection() {
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+// Split "tcp:host:port" into host and port
+static bool parse_tcp_endpoint(const std::string& rest, std::string& host, std::string& port) {
+    size_t colon = rest.rfind(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    host = rest.substr(0, colon);
+    port = rest.substr(colon + 1);
+    return !port.empty();
+}
+
+int NetProtocol::listen_endpoint(const std::string& endpoint) {
+    int fd = -1;
+
+    if (endpoint.compare(0, 5, "unix:") == 0) {
+        std::string path = endpoint.substr(5);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.length() >= sizeof(addr.sun_path)) {
+            std::cerr << "[NET] Error: socket path too long: " << path << std::endl;
+            return -1;
+        }
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(path.c_str());
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+            std::cerr << "[NET] Error: could not bind " << endpoint << std::endl;
+            if (fd != -1) {
+                close(fd);
+            }
+            return -1;
+        }
+    }
+    else if (endpoint.compare(0, 4, "tcp:") == 0) {
+        std::string host, port;
+        if (!parse_tcp_endpoint(endpoint.substr(4), host, port)) {
+            std::cerr << "[NET] Error: bad endpoint " << endpoint << std::endl;
+            return -1;
+        }
+
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+
+        struct addrinfo* res = nullptr;
+        if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &res) != 0) {
+            std::cerr << "[NET] Error: could not resolve " << endpoint << std::endl;
+            return -1;
+        }
+
+        for (struct addrinfo* ai = res; ai != nullptr; ai = ai->ai_next) {
+            fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd == -1) {
+                continue;
+            }
+            int yes = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+            if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                break;
+            }
+            close(fd);
+            fd = -1;
+        }
+        freeaddrinfo(res);
+
+        if (fd == -1) {
+            std::cerr << "[NET] Error: could not bind " << endpoint << std::endl;
+            return -1;
+        }
+    }
+    else {
+        std::cerr << "[NET] Error: endpoint must start with unix: or tcp:" << std::endl;
+        return -1;
+    }
+
+    if (listen(fd, 64) == -1) {
+        std::cerr << "[NET] Error: listen failed on " << endpoint << std::endl;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Try a single connection attempt to the endpoint
+static int connect_once(const std::string& endpoint) {
+    if (endpoint.compare(0, 5, "unix:") == 0) {
+        std::string path = endpoint.substr(5);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd != -1 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    std::string host, port;
+    if (endpoint.compare(0, 4, "tcp:") != 0 ||
+        !parse_tcp_endpoint(endpoint.substr(4), host, port)) {
+        return -1;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* res = nullptr;
+    if (getaddrinfo(host.empty() ? "localhost" : host.c_str(), port.c_str(), &hints, &res) != 0) {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = res; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd == -1) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            // Frames are small, do not let Nagle hold them back
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int NetProtocol::connect_endpoint(const std::string& endpoint, int retry_seconds) {
+    // Retry so workers can be started before the coordinator is listening
+    for (int attempt = 0; attempt <= retry_seconds * 10; attempt++) {
+        int fd = connect_once(endpoint);
+        if (fd != -1) {
+            return fd;
+        }
+        usleep(100000); // 0.1 seconds
+    }
+    std::cerr << "[NET] Error: could not connect to " << endpoint << std::endl;
+    return -1;
+}
+
+void NetProtocol::remove_endpoint(const std::string& endpoint) {
+    if (endpoint.compare(0, 5, "unix:") == 0) {
+        unlink(endpoint.substr(5).c_str());
+    }
+}
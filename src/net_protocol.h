@@ -0,0 +1,106 @@
+#ifndef NET_PROTOCOL_H
+#define NET_PROTOCOL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Compact binary protocol between the coordinator and remote TA workers.
+// Every frame is a 5-byte header (u8 type, u32 payload length) followed by
+// the payload. All integers are big-endian on the wire.
+enum MessageType {
+    MSG_HELLO = 1,          // worker -> coordinator: u32 worker_id
+    MSG_WELCOME = 2,        // coordinator -> worker: 5 x (u8 len, bytes) rubric lines
+    MSG_LEASE_REQUEST = 3,  // worker -> coordinator: u16 max_items
+    MSG_LEASE = 4,          // coordinator -> worker: u16 n, n x (i64 student, u8 question)
+    MSG_RESULT = 5,         // worker -> coordinator: i64 student, u8 question, u32 millis
+    MSG_RUBRIC_FIX = 6,     // worker -> coordinator: u8 question, u8 char seen by worker
+    MSG_RUBRIC_UPDATE = 7,  // coordinator -> worker: u8 question, u8 len, bytes
+    MSG_SHUTDOWN = 8        // coordinator -> worker: no more work
+};
+
+struct Message {
+    uint8_t type;
+    std::vector<uint8_t> payload;
+};
+
+// One unit of work handed out by the coordinator
+struct WorkItem {
+    int64_t student_number;
+    uint8_t question;  // 0-based question index
+};
+
+// Builds a message payload
+class PayloadWriter {
+private:
+    std::vector<uint8_t> data;
+
+public:
+    void put_u8(uint8_t value);
+    void put_u16(uint16_t value);
+    void put_u32(uint32_t value);
+    void put_i64(int64_t value);
+    void put_string(const std::string& value);  // u8 length prefix, max 255 bytes
+
+    Message to_message(uint8_t type) const;
+};
+
+// Reads fields back out of a payload; sets ok() to false on underflow
+class PayloadReader {
+private:
+    const std::vector<uint8_t>& data;
+    size_t pos;
+    bool valid;
+
+    bool need(size_t bytes);
+
+public:
+    explicit PayloadReader(const std::vector<uint8_t>& payload);
+
+    uint8_t get_u8();
+    uint16_t get_u16();
+    uint32_t get_u32();
+    int64_t get_i64();
+    std::string get_string();
+    bool ok() const;
+};
+
+// Buffered, pipelined connection: outgoing frames are queued and flushed
+// together, incoming bytes are split into frames as they arrive. A server
+// serving many peers makes the socket non-blocking and uses send_available()
+// on POLLOUT, so one stalled peer cannot hold up the others.
+class Connection {
+private:
+    int fd;
+    std::vector<uint8_t> in_buf;
+    std::vector<uint8_t> out_buf;
+
+public:
+    explicit Connection(int socket_fd);
+    ~Connection();
+
+    int get_fd() const;
+
+    bool set_nonblocking();
+    void queue(const Message& msg);  // Append a frame to the outgoing buffer
+    bool flush();                    // Write all queued frames (blocking socket)
+    bool send_available();           // Write what the socket takes now; false on error
+    bool has_output() const;         // Queued bytes not written yet
+    bool read_available();           // One recv(); false on EOF or error
+    bool next_message(Message& msg); // Pop one complete frame, if any; closes on an oversized one
+    bool is_open() const;
+    void close_connection();
+};
+
+class NetProtocol {
+public:
+    static const uint32_t MAX_PAYLOAD;      // Larger frames close the connection
+    static const int MAX_LEASE_ITEMS;       // Most items one lease request can ask for
+
+    // Endpoints are "unix:/path/to/socket" or "tcp:host:port"
+    static int listen_endpoint(const std::string& endpoint);
+    static int connect_endpoint(const std::string& endpoint, int retry_seconds);
+    static void remove_endpoint(const std::string& endpoint);
+};
+
+#endif
@@ -0,0 +1,194 @@
+// net_worker.cpp
+// TA worker that leases questions from a coordinator and streams results back
+
+#include "net_worker.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <poll.h>
+#include <unistd.h>
+
+NetWorker::NetWorker(int id, const std::string& ep, int batch)
+    : worker_id(id), endpoint(ep), batch_size(batch < 1 ? 1 : batch), conn(nullptr),
+      lease_outstanding(false), shutdown(false) {
+    memset(&rubric, 0, sizeof(rubric));
+    // Seed random number generator with worker ID and time
+    srand(time(nullptr) + worker_id);
+}
+
+NetWorker::~NetWorker() {
+    delete conn;
+}
+
+double NetWorker::get_random_delay(double min, double max) {
+    double random = (double)rand() / RAND_MAX;
+    return min + random * (max - min);
+}
+
+bool NetWorker::handle_message(const Message& msg) {
+    PayloadReader reader(msg.payload);
+
+    switch (msg.type) {
+    case MSG_WELCOME:
+        for (int q = 0; q < 5; q++) {
+            std::string line = reader.get_string();
+            strncpy(rubric.rubric_text[q], line.c_str(), 99);
+            rubric.rubric_text[q][99] = '\0';
+        }
+        break;
+    case MSG_LEASE: {
+        int count = reader.get_u16();
+        for (int i = 0; i < count && reader.ok(); i++) {
+            WorkItem item;
+            item.student_number = reader.get_i64();
+            item.question = reader.get_u8();
+            work.push_back(item);
+        }
+        lease_outstanding = false;
+        break;
+    }
+    case MSG_RUBRIC_UPDATE: {
+        int q = reader.get_u8();
+        std::string line = reader.get_string();
+        if (reader.ok() && q >= 0 && q < 5) {
+            strncpy(rubric.rubric_text[q], line.c_str(), 99);
+            rubric.rubric_text[q][99] = '\0';
+        }
+        break;
+    }
+    case MSG_SHUTDOWN:
+        shutdown = true;
+        break;
+    default:
+        std::cerr << "[WORKER " << worker_id << "] Unknown message type " << (int)msg.type << std::endl;
+        return false;
+    }
+
+    return reader.ok();
+}
+
+bool NetWorker::pump(bool block) {
+    struct pollfd pfd;
+    pfd.fd = conn->get_fd();
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    while (!shutdown && poll(&pfd, 1, block ? -1 : 0) > 0) {
+        if (!conn->read_available()) {
+            return false;
+        }
+        Message msg;
+        while (conn->next_message(msg)) {
+            if (!handle_message(msg)) {
+                return false;
+            }
+        }
+        if (!conn->is_open()) {
+            return false;
+        }
+        // One blocking read is enough, then drain whatever else is ready
+        block = false;
+        pfd.revents = 0;
+    }
+    return true;
+}
+
+void NetWorker::request_more_work() {
+    // Ask for the next batch while the current one is still being marked,
+    // so the lease round trip overlaps with marking
+    if (lease_outstanding || (int)work.size() > batch_size / 2) {
+        return;
+    }
+    PayloadWriter request;
+    request.put_u16((uint16_t)batch_size);
+    conn->queue(request.to_message(MSG_LEASE_REQUEST));
+    lease_outstanding = true;
+}
+
+void NetWorker::review_rubric() {
+    for (int q = 0; q < 5; q++) {
+        double delay = get_random_delay(0.5, 1.0);
+        usleep(delay * 1000000);
+
+        // Randomly decide if correction is needed (30% chance)
+        if ((rand() % 100) >= 30) {
+            continue;
+        }
+
+        std::string line = rubric.rubric_text[q];
+        size_t comma_pos = line.find(',');
+        if (comma_pos != std::string::npos && comma_pos + 2 < line.length()) {
+            std::cout << "[WORKER " << worker_id << "] Detected error in rubric for question "
+                      << (q + 1) << ", sending correction" << std::endl;
+
+            // The coordinator owns the rubric and broadcasts the new line
+            PayloadWriter fix;
+            fix.put_u8((uint8_t)q);
+            fix.put_u8((uint8_t)line[comma_pos + 2]);
+            conn->queue(fix.to_message(MSG_RUBRIC_FIX));
+        }
+    }
+}
+
+uint32_t NetWorker::mark_question(const WorkItem& item) {
+    std::cout << "[WORKER " << worker_id << "] Marking question " << (item.question + 1)
+              << " for student " << item.student_number << std::endl;
+
+    // Simulate marking time (1.0 to 2.0 seconds)
+    double delay = get_random_delay(1.0, 2.0);
+    usleep(delay * 1000000);
+    return (uint32_t)(delay * 1000);
+}
+
+bool NetWorker::run() {
+    int fd = NetProtocol::connect_endpoint(endpoint, 10);
+    if (fd == -1) {
+        return false;
+    }
+    conn = new Connection(fd);
+
+    PayloadWriter hello;
+    hello.put_u32((uint32_t)worker_id);
+    conn->queue(hello.to_message(MSG_HELLO));
+    request_more_work();
+    if (!conn->flush()) {
+        return false;
+    }
+
+    std::cout << "[WORKER " << worker_id << "] Connected to " << endpoint << std::endl;
+
+    while (!shutdown) {
+        // Wait only when there is nothing left to mark locally
+        if (!pump(work.empty())) {
+            std::cerr << "[WORKER " << worker_id << "] Lost connection to coordinator" << std::endl;
+            return false;
+        }
+        if (work.empty()) {
+            continue;
+        }
+
+        WorkItem item = work.front();
+        work.pop_front();
+        request_more_work();
+        conn->flush();
+
+        review_rubric();
+        uint32_t millis = mark_question(item);
+
+        // Stream the result back without waiting for an acknowledgement
+        PayloadWriter result;
+        result.put_i64(item.student_number);
+        result.put_u8(item.question);
+        result.put_u32(millis);
+        conn->queue(result.to_message(MSG_RESULT));
+        request_more_work();
+        if (!conn->flush()) {
+            std::cerr << "[WORKER " << worker_id << "] Lost connection to coordinator" << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "[WORKER " << worker_id << "] Coordinator finished, stopping" << std::endl;
+    return true;
+}
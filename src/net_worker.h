@@ -0,0 +1,35 @@
+#ifndef NET_WORKER_H
+#define NET_WORKER_H
+
+#include "net_protocol.h"
+#include "shared_memory.h"
+#include <deque>
+#include <string>
+
+// A TA that marks questions leased from a remote coordinator
+class NetWorker {
+private:
+    int worker_id;
+    std::string endpoint;
+    int batch_size;
+    Connection* conn;
+    RubricData rubric;              // Local copy, kept current by RUBRIC_UPDATE
+    std::deque<WorkItem> work;      // Leased items not yet marked
+    bool lease_outstanding;
+    bool shutdown;
+
+    bool handle_message(const Message& msg);
+    bool pump(bool block);          // Read and dispatch incoming frames
+    void request_more_work();
+    void review_rubric();
+    uint32_t mark_question(const WorkItem& item);
+    double get_random_delay(double min, double max);
+
+public:
+    NetWorker(int id, const std::string& endpoint, int batch_size);
+    ~NetWorker();
+
+    bool run();
+};
+
+#endif
@@ -0,0 +1,82 @@
+// race_detector.cpp
+// Counts double claims, duplicate/skipped exam loads and lost rubric updates
+
+#include "race_detector.h"
+#include "shared_memory.h"
+#include <iostream>
+#include <cstring>
+
+void RaceDetector::start(RaceCounters* races, int64_t first_index) {
+    memset(races, 0, sizeof(RaceCounters));
+    races->load_high_water = first_index;
+    races->enabled = true;
+}
+
+bool RaceDetector::record_claim(RaceCounters* races, ExamData* exam, int question_num) {
+    if (!races->enabled) {
+        return false;
+    }
+    // Claims of one question are numbered; any claim after the first is a double claim
+    if (__atomic_fetch_add(&exam->claim_count[question_num], 1, __ATOMIC_RELAXED) == 0) {
+        return false;
+    }
+    __atomic_fetch_add(&races->double_claims, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+void RaceDetector::record_duplicate_mark(RaceCounters* races, double seconds) {
+    if (!races->enabled) {
+        return;
+    }
+    __atomic_fetch_add(&races->duplicate_marks, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&races->wasted_mark_ms, (uint64_t)(seconds * 1000), __ATOMIC_RELAXED);
+}
+
+void RaceDetector::record_load(RaceCounters* races, int64_t exam_index) {
+    if (!races->enabled) {
+        return;
+    }
+
+    // Raise the high-water mark; whatever it was before tells us what happened
+    int64_t seen = __atomic_load_n(&races->load_high_water, __ATOMIC_RELAXED);
+    while (exam_index > seen &&
+           !__atomic_compare_exchange_n(&races->load_high_water, &seen, exam_index, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    if (exam_index <= seen) {
+        __atomic_fetch_add(&races->duplicate_loads, 1, __ATOMIC_RELAXED);
+    } else if (exam_index > seen + 1) {
+        __atomic_fetch_add(&races->skipped_exams, (uint64_t)(exam_index - seen - 1), __ATOMIC_RELAXED);
+    }
+}
+
+void RaceDetector::record_correction(RaceCounters* races, int question_num, bool overwrote) {
+    if (!races->enabled) {
+        return;
+    }
+    __atomic_fetch_add(&races->corrections[question_num], 1, __ATOMIC_RELAXED);
+    if (overwrote) {
+        __atomic_fetch_add(&races->lost_corrections, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void RaceDetector::print_report(const RaceCounters* races, double run_seconds) {
+    if (!races->enabled) {
+        return;
+    }
+
+    uint64_t attempted = 0;
+    for (int q = 0; q < 5; q++) {
+        attempted += races->corrections[q];
+    }
+
+    std::cout << "\nRace detector (" << run_seconds << " s run):" << std::endl;
+    std::cout << "  Double-claimed questions: " << races->double_claims << " ("
+              << races->duplicate_marks << " marked twice, " << races->wasted_mark_ms / 1000.0
+              << " s of marking wasted)" << std::endl;
+    std::cout << "  Duplicate exam loads: " << races->duplicate_loads << std::endl;
+    std::cout << "  Skipped exams: " << races->skipped_exams << std::endl;
+    std::cout << "  Rubric corrections: " << attempted << " made, " << races->lost_corrections
+              << " lost" << std::endl;
+}
@@ -0,0 +1,44 @@
+#ifndef RACE_DETECTOR_H
+#define RACE_DETECTOR_H
+
+#include <cstdint>
+
+struct ExamData;
+
+// Damage done by unsynchronized TAs (in shared memory). Every counter is
+// updated with atomic instructions, so the detector adds no locking of its own.
+struct RaceCounters {
+    bool enabled;                   // Set by --detect-races
+    int64_t load_high_water;        // Highest exam index loaded so far
+    uint64_t double_claims;         // Questions claimed while another TA had them
+    uint64_t duplicate_marks;       // Double claims that were marked to the end
+    uint64_t wasted_mark_ms;        // Marking time spent on those
+    uint64_t duplicate_loads;       // Loads of an index that was already loaded
+    uint64_t skipped_exams;         // Indices jumped over by a load
+    uint64_t corrections[5];        // Rubric increments TAs believe they applied
+    uint64_t lost_corrections;      // Rubric updates overwritten by a stale write
+};
+
+class RaceDetector {
+public:
+    // Enable detection; first_index is the exam the main process loaded
+    static void start(RaceCounters* races, int64_t first_index);
+
+    // A TA claimed a question. Returns true if another TA already had it.
+    static bool record_claim(RaceCounters* races, ExamData* exam, int question_num);
+
+    // A double-claimed question was marked anyway
+    static void record_duplicate_mark(RaceCounters* races, double seconds);
+
+    // A TA loaded the exam at this index of the exam list
+    static void record_load(RaceCounters* races, int64_t exam_index);
+
+    // A TA incremented a rubric line; overwrote is set when the line it wrote
+    // over no longer held what the TA had read
+    static void record_correction(RaceCounters* races, int question_num, bool overwrote);
+
+    // Print the counters
+    static void print_report(const RaceCounters* races, double run_seconds);
+};
+
+#endif
@@ -0,0 +1,339 @@
+// results.cpp
+// Per-TA result logs and the end-of-run merge into CSV files
+
+#include "results.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const std::string Results::RESULTS_DIR = "data/results/";
+const std::string Results::STUDENTS_FILENAME = "data/results/students.csv";
+const std::string Results::TAS_FILENAME = "data/results/tas.csv";
+
+static const char PART_PREFIX[] = "ta_";
+static const char PART_SUFFIX[] = ".part";
+
+ResultsLog::ResultsLog() : ta_id(-1) {
+}
+
+ResultsLog::~ResultsLog() {
+    close();
+}
+
+static FILE* open_part(int ta_id, int slot) {
+    std::string filename = Results::part_filename(ta_id, slot);
+    FILE* part = fopen(filename.c_str(), "ab");
+    if (part == nullptr) {
+        std::cerr << "[TA " << ta_id << "] Error: Could not open " << filename << std::endl;
+    }
+    return part;
+}
+
+bool ResultsLog::open(int id) {
+    ta_id = id;
+    parts.assign(1, open_part(ta_id, 0));
+    return parts[0] != nullptr;
+}
+
+void ResultsLog::record(const MarkRecord& rec, int slot) {
+    if (ta_id < 0) {
+        return;
+    }
+    if (slot >= (int)parts.size()) {
+        parts.resize(slot + 1, nullptr);
+    }
+    if (parts[slot] == nullptr) {
+        parts[slot] = open_part(ta_id, slot);
+        if (parts[slot] == nullptr) {
+            return;
+        }
+    }
+    // Flushed per record so a stopped TA loses nothing it already marked
+    fwrite(&rec, sizeof(rec), 1, parts[slot]);
+    fflush(parts[slot]);
+}
+
+void ResultsLog::close() {
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (parts[i] != nullptr) {
+            fclose(parts[i]);
+        }
+    }
+    parts.clear();
+    ta_id = -1;
+}
+
+// ta_<id>.part, or ta_<id>.<slot>.part for exam slots after the first
+std::string Results::part_filename(int ta_id, int slot) {
+    std::string slot_suffix = (slot == 0) ? std::string() : "." + std::to_string(slot);
+    return RESULTS_DIR + PART_PREFIX + std::to_string(ta_id) + slot_suffix + PART_SUFFIX;
+}
+
+static bool is_part_file(const char* name) {
+    size_t len = strlen(name);
+    size_t prefix = strlen(PART_PREFIX);
+    size_t suffix = strlen(PART_SUFFIX);
+    return len > prefix + suffix && strncmp(name, PART_PREFIX, prefix) == 0 &&
+           strcmp(name + len - suffix, PART_SUFFIX) == 0;
+}
+
+// (TA id, slot) of a part file name, read as ta_<id>[.<slot>].part
+static std::pair<long, long> part_key(const std::string& filename) {
+    const char* name = filename.c_str() + Results::RESULTS_DIR.size() + strlen(PART_PREFIX);
+    char* end = nullptr;
+    long ta_id = strtol(name, &end, 10);
+    long slot = (*end == '.') ? strtol(end + 1, nullptr, 10) : 0;
+    return std::make_pair(ta_id, slot);
+}
+
+static bool part_before(const std::string& a, const std::string& b) {
+    return part_key(a) < part_key(b);
+}
+
+// Part files in (TA id, slot) order rather than readdir order, so the merge
+// resolves re-marks across files the same way every run
+static std::vector<std::string> list_part_files() {
+    std::vector<std::string> parts;
+    DIR* dir = opendir(Results::RESULTS_DIR.c_str());
+    if (!dir) {
+        return parts;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (is_part_file(entry->d_name)) {
+            parts.push_back(Results::RESULTS_DIR + entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(parts.begin(), parts.end(), part_before);
+    return parts;
+}
+
+bool Results::prepare(bool resume) {
+    if (mkdir(RESULTS_DIR.c_str(), 0755) == -1 && errno != EEXIST) {
+        std::cerr << "Error: Could not create " << RESULTS_DIR << std::endl;
+        return false;
+    }
+    if (!resume) {
+        std::vector<std::string> parts = list_part_files();
+        for (size_t i = 0; i < parts.size(); i++) {
+            unlink(parts[i].c_str());
+        }
+    }
+    return true;
+}
+
+// Records of one exam are grouped by (exam_index, student_number): racing
+// Part A TAs can load two students under the same index
+static bool record_before(const MarkRecord& a, const MarkRecord& b) {
+    if (a.exam_index != b.exam_index) {
+        return a.exam_index < b.exam_index;
+    }
+    return a.student_number < b.student_number;
+}
+
+// A part file is only appended to in exam order by a single run. Resumed runs
+// and racing Part A loads break that, so sort it (stably, keeping re-marks in
+// the order they happened) before the streaming merge relies on it.
+static bool sort_part_file(const std::string& filename) {
+    FILE* part = fopen(filename.c_str(), "rb");
+    if (part == nullptr) {
+        return false;
+    }
+    std::vector<MarkRecord> records;
+    MarkRecord rec;
+    while (fread(&rec, sizeof(rec), 1, part) == 1) {
+        records.push_back(rec);
+    }
+    fclose(part);
+    
+    if (std::is_sorted(records.begin(), records.end(), record_before)) {
+        return true;
+    }
+    std::stable_sort(records.begin(), records.end(), record_before);
+    
+    // Write a temporary file and rename it so a failed write keeps the original
+    std::string temp_filename = filename + ".tmp";
+    FILE* sorted = fopen(temp_filename.c_str(), "wb");
+    if (sorted == nullptr) {
+        std::cerr << "Error: Could not write " << temp_filename << std::endl;
+        return false;
+    }
+    bool ok = fwrite(records.data(), sizeof(MarkRecord), records.size(), sorted) == records.size();
+    ok = fclose(sorted) == 0 && ok;
+    if (!ok || rename(temp_filename.c_str(), filename.c_str()) == -1) {
+        std::cerr << "Error: Could not rewrite " << filename << std::endl;
+        unlink(temp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Head of one part file during the merge
+struct PartCursor {
+    MarkRecord rec;
+    size_t part;
+    bool operator>(const PartCursor& other) const {
+        if (record_before(other.rec, rec)) {
+            return true;
+        }
+        if (record_before(rec, other.rec)) {
+            return false;
+        }
+        return part > other.part;
+    }
+};
+
+// One row of students.csv, filled while its exam's records are merged. A
+// question marked more than once keeps only its last record.
+struct StudentRow {
+    int64_t exam_index;
+    int64_t student_number;
+    int ta[5];
+    uint32_t mark_ms[5];
+};
+
+struct TaTotals {
+    uint64_t questions;
+    uint64_t exams;
+    uint64_t mark_ms;
+};
+
+// Write one students.csv row and add its kept records to the TA totals
+static void write_student_row(FILE* out, const StudentRow& row, std::map<int, TaTotals>& tas,
+                              uint64_t& complete) {
+    int marked = 0;
+    uint64_t mark_ms = 0;
+    fprintf(out, "%lld,%lld", (long long)row.exam_index, (long long)row.student_number);
+    for (int q = 0; q < 5; q++) {
+        if (row.ta[q] < 0) {
+            fprintf(out, ",");
+            continue;
+        }
+        fprintf(out, ",%d", row.ta[q]);
+        marked++;
+        mark_ms += row.mark_ms[q];
+        
+        std::map<int, TaTotals>::iterator it = tas.find(row.ta[q]);
+        if (it == tas.end()) {
+            TaTotals fresh = {0, 0, 0};
+            it = tas.insert(std::make_pair(row.ta[q], fresh)).first;
+        }
+        it->second.questions++;
+        it->second.mark_ms += row.mark_ms[q];
+        
+        // Count the exam once per TA, at that TA's first question in the row
+        bool first_for_ta = true;
+        for (int earlier = 0; earlier < q; earlier++) {
+            first_for_ta = first_for_ta && row.ta[earlier] != row.ta[q];
+        }
+        if (first_for_ta) {
+            it->second.exams++;
+        }
+    }
+    fprintf(out, ",%d,%.3f,%d\n", marked, mark_ms / 1000.0, marked == 5 ? 1 : 0);
+    if (marked == 5) {
+        complete++;
+    }
+}
+
+bool Results::merge(double run_seconds) {
+    std::vector<std::string> part_names = list_part_files();
+    std::vector<FILE*> parts;
+    std::priority_queue<PartCursor, std::vector<PartCursor>, std::greater<PartCursor> > heads;
+
+    for (size_t i = 0; i < part_names.size(); i++) {
+        FILE* part = sort_part_file(part_names[i]) ? fopen(part_names[i].c_str(), "rb") : nullptr;
+        if (part == nullptr) {
+            continue;
+        }
+        PartCursor cursor;
+        cursor.part = parts.size();
+        parts.push_back(part);
+        if (fread(&cursor.rec, sizeof(cursor.rec), 1, part) == 1) {
+            heads.push(cursor);
+        }
+    }
+
+    FILE* students = fopen(STUDENTS_FILENAME.c_str(), "w");
+    if (students == nullptr) {
+        std::cerr << "Error: Could not write " << STUDENTS_FILENAME << std::endl;
+        for (size_t i = 0; i < parts.size(); i++) {
+            fclose(parts[i]);
+        }
+        return false;
+    }
+    fprintf(students, "exam_index,student_number,q1_ta,q2_ta,q3_ta,q4_ta,q5_ta,questions_marked,marking_seconds,complete\n");
+
+    std::map<int, TaTotals> tas;
+    StudentRow row;
+    bool have_row = false;
+    uint64_t rows = 0, complete = 0;
+
+    while (!heads.empty()) {
+        PartCursor cursor = heads.top();
+        heads.pop();
+        const MarkRecord& rec = cursor.rec;
+
+        // Records arrive grouped by exam; a new exam closes the previous row
+        if (!have_row || rec.exam_index != row.exam_index || rec.student_number != row.student_number) {
+            if (have_row) {
+                write_student_row(students, row, tas, complete);
+                rows++;
+            }
+            row.exam_index = rec.exam_index;
+            row.student_number = rec.student_number;
+            for (int q = 0; q < 5; q++) {
+                row.ta[q] = -1;
+                row.mark_ms[q] = 0;
+            }
+            have_row = true;
+        }
+        // A re-mark replaces the earlier record (within a part file they arrive
+        // in the order marked; between part files the one with the higher TA
+        // id, then slot, wins)
+        if (rec.question >= 0 && rec.question < 5) {
+            row.ta[rec.question] = rec.ta_id;
+            row.mark_ms[rec.question] = rec.mark_ms;
+        }
+
+        if (fread(&cursor.rec, sizeof(cursor.rec), 1, parts[cursor.part]) == 1) {
+            heads.push(cursor);
+        }
+    }
+    if (have_row) {
+        write_student_row(students, row, tas, complete);
+        rows++;
+    }
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        fclose(parts[i]);
+    }
+    bool ok = fclose(students) == 0;
+
+    FILE* ta_file = fopen(TAS_FILENAME.c_str(), "w");
+    if (ta_file == nullptr) {
+        std::cerr << "Error: Could not write " << TAS_FILENAME << std::endl;
+        return false;
+    }
+    fprintf(ta_file, "ta_id,questions_marked,exams,marking_seconds,questions_per_hour\n");
+    for (std::map<int, TaTotals>::iterator it = tas.begin(); it != tas.end(); ++it) {
+        double per_hour = run_seconds > 0 ? it->second.questions * 3600.0 / run_seconds : 0.0;
+        fprintf(ta_file, "%d,%llu,%llu,%.3f,%.1f\n", it->first,
+                (unsigned long long)it->second.questions, (unsigned long long)it->second.exams,
+                it->second.mark_ms / 1000.0, per_hour);
+    }
+    ok = fclose(ta_file) == 0 && ok;
+
+    std::cout << "\nResults: " << rows << " exams (" << complete << " complete) in "
+              << STUDENTS_FILENAME << ", " << tas.size() << " TAs in " << TAS_FILENAME << std::endl;
+    return ok;
+}
@@ -0,0 +1,57 @@
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// One marked question, as appended to a TA's part file
+struct MarkRecord {
+    int64_t exam_index;     // Position in the run, increases as exams are loaded
+    int64_t student_number;
+    int32_t question;       // 0-4
+    int32_t ta_id;
+    uint32_t mark_ms;       // Time spent marking the question
+    uint32_t reserved;
+};
+
+// Per-TA append-only log of marked questions. Each TA writes its own file,
+// so recording needs no locking and records normally stay in exam_index
+// order (Results::merge sorts any file where they do not). With
+// several active exams a TA keeps one file per exam slot, since each slot
+// loads exams in order but a TA moving between slots does not.
+class ResultsLog {
+private:
+    int ta_id;
+    std::vector<FILE*> parts;   // Indexed by exam slot, opened on first use
+
+public:
+    ResultsLog();
+    ~ResultsLog();
+
+    bool open(int ta_id);
+    void record(const MarkRecord& rec, int slot = 0);
+    void close();
+};
+
+class Results {
+public:
+    static const std::string RESULTS_DIR;
+    static const std::string STUDENTS_FILENAME;
+    static const std::string TAS_FILENAME;
+
+    static std::string part_filename(int ta_id, int slot = 0);
+
+    // Create the results directory. Part files from an earlier run are removed
+    // unless resuming, in which case TAs append to them.
+    static bool prepare(bool resume);
+
+    // Merge every part file by exam into students.csv (one row per exam) and
+    // tas.csv (one row per TA), counting only the last record of a question
+    // that was marked more than once. Each part file is sorted first; the
+    // merge itself reads one record per part file at a time.
+    static bool merge(double run_seconds);
+};
+
+#endif
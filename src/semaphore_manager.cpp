@@ -2,23 +2,26 @@
 // Implementation of semaphore operations for synchronization
 
 #include "semaphore_manager.h"
+#include "shared_memory.h"
 #include <iostream>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
 #include <cstring>
+#include <ctime>
+#include <climits>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 SemaphoreManager::SemaphoreManager() 
     : rubric_mutex(SEM_FAILED),
       reader_count_mutex(SEM_FAILED),
-      reader_count(nullptr),
+      lock_data(nullptr),
       shm_id_reader_count(-1),
       exam_load_mutex(SEM_FAILED)
 {
-    for (int i = 0; i < 5; i++) {
-        question_mutexes[i] = SEM_FAILED;
-    }
 }
 
 SemaphoreManager::~SemaphoreManager() {
@@ -26,36 +29,47 @@ SemaphoreManager::~SemaphoreManager() {
 }
 
 // Create all semaphores and shared memory for reader_count
-bool SemaphoreManager::initialize() {
+bool SemaphoreManager::initialize(int exam_slots) {
     std::cout << "[SEM] Initializing semaphores..." << std::endl;
     
-    // Create shared memory for reader_count (needed for readers-writers)
+    // Create shared memory for reader_count and wait statistics (needed for readers-writers)
     key_t key = ftok(".", 'C');
     if (key == -1) {
         std::cerr << "[SEM] Error: ftok failed for reader_count" << std::endl;
         return false;
     }
     
-    shm_id_reader_count = shmget(key, sizeof(int), IPC_CREAT | 0666);
+    shm_id_reader_count = shmget(key, sizeof(RubricLockData), IPC_CREAT | 0666);
+    if (shm_id_reader_count == -1) {
+        // A smaller segment left by a crashed run, replace it
+        int stale_id = shmget(key, 0, 0);
+        if (stale_id != -1) {
+            shmctl(stale_id, IPC_RMID, nullptr);
+            shm_id_reader_count = shmget(key, sizeof(RubricLockData), IPC_CREAT | 0666);
+        }
+    }
     if (shm_id_reader_count == -1) {
         std::cerr << "[SEM] Error: shmget failed for reader_count" << std::endl;
         return false;
     }
     
-    reader_count = (int*)shmat(shm_id_reader_count, nullptr, 0);
-    if (reader_count == (void*)-1) {
+    lock_data = (RubricLockData*)shmat(shm_id_reader_count, nullptr, 0);
+    if (lock_data == (void*)-1) {
         std::cerr << "[SEM] Error: shmat failed for reader_count" << std::endl;
+        lock_data = nullptr;
         return false;
     }
-    *reader_count = 0;
+    memset(lock_data, 0, sizeof(RubricLockData));
     
     // Create rubric semaphores (readers-writers)
+    sem_unlink("/rubric_mutex");  // Drop a stale semaphore left by a crashed run
     rubric_mutex = sem_open("/rubric_mutex", O_CREAT, 0666, 1);
     if (rubric_mutex == SEM_FAILED) {
         std::cerr << "[SEM] Error: sem_open failed for rubric_mutex" << std::endl;
         return false;
     }
     
+    sem_unlink("/reader_count_mutex");
     reader_count_mutex = sem_open("/reader_count_mutex", O_CREAT, 0666, 1);
     if (reader_count_mutex == SEM_FAILED) {
         std::cerr << "[SEM] Error: sem_open failed for reader_count_mutex" << std::endl;
@@ -63,6 +77,7 @@ bool SemaphoreManager::initialize() {
     }
     
     // Create exam loading semaphore
+    sem_unlink("/exam_load_mutex");
     exam_load_mutex = sem_open("/exam_load_mutex", O_CREAT, 0666, 1);
     if (exam_load_mutex == SEM_FAILED) {
         std::cerr << "[SEM] Error: sem_open failed for exam_load_mutex" << std::endl;
@@ -70,20 +85,84 @@ bool SemaphoreManager::initialize() {
     }
     
     // Create question semaphores (one per question)
-    for (int i = 0; i < 5; i++) {
+    if (!open_slot_semaphores(exam_slots, true)) {
+        return false;
+    }
+    
+    std::cout << "[SEM] All semaphores initialized successfully" << std::endl;
+    return true;
+}
+
+// Question q of exam slot s is "/question_mutex_<5*s+q>", so slot 0 keeps
+// the names used before there were several slots; the slot lock is
+// "/exam_slot_mutex_<s>"
+bool SemaphoreManager::open_slot_semaphores(int exam_slots, bool create) {
+    // Drop semaphores of every slot a crashed run may have used, not only ours
+    for (int i = 0; create && i < MAX_EXAM_SLOTS * 5; i++) {
         char sem_name[50];
         snprintf(sem_name, sizeof(sem_name), "/question_mutex_%d", i);
-        question_mutexes[i] = sem_open(sem_name, O_CREAT, 0666, 1);
-        if (question_mutexes[i] == SEM_FAILED) {
+        sem_unlink(sem_name);
+        if (i < MAX_EXAM_SLOTS) {
+            snprintf(sem_name, sizeof(sem_name), "/exam_slot_mutex_%d", i);
+            sem_unlink(sem_name);
+        }
+    }
+    
+    slot_mutexes.assign(exam_slots, SEM_FAILED);
+    for (size_t i = 0; i < slot_mutexes.size(); i++) {
+        char sem_name[50];
+        snprintf(sem_name, sizeof(sem_name), "/exam_slot_mutex_%d", (int)i);
+        if (create) {
+            slot_mutexes[i] = sem_open(sem_name, O_CREAT, 0666, 1);
+        } else {
+            slot_mutexes[i] = sem_open(sem_name, 0);
+        }
+        if (slot_mutexes[i] == SEM_FAILED) {
             std::cerr << "[SEM] Error: sem_open failed for " << sem_name << std::endl;
             return false;
         }
     }
     
-    std::cout << "[SEM] All semaphores initialized successfully" << std::endl;
+    question_mutexes.assign(exam_slots * 5, SEM_FAILED);
+    for (size_t i = 0; i < question_mutexes.size(); i++) {
+        char sem_name[50];
+        snprintf(sem_name, sizeof(sem_name), "/question_mutex_%d", (int)i);
+        if (create) {
+            question_mutexes[i] = sem_open(sem_name, O_CREAT, 0666, 1);
+        } else {
+            question_mutexes[i] = sem_open(sem_name, 0);
+        }
+        if (question_mutexes[i] == SEM_FAILED) {
+            std::cerr << "[SEM] Error: sem_open failed for " << sem_name << std::endl;
+            return false;
+        }
+    }
     return true;
 }
 
+bool SemaphoreManager::attach(int exam_slots) {
+    key_t key = ftok(".", 'C');
+    int shm_id = (key == -1) ? -1 : shmget(key, 0, 0);
+    lock_data = (shm_id == -1) ? (RubricLockData*)-1 : (RubricLockData*)shmat(shm_id, nullptr, 0);
+    if (lock_data == (void*)-1) {
+        std::cerr << "[SEM] Error: Could not attach to reader_count" << std::endl;
+        lock_data = nullptr;
+        return false;
+    }
+    
+    rubric_mutex = sem_open("/rubric_mutex", 0);
+    reader_count_mutex = sem_open("/reader_count_mutex", 0);
+    exam_load_mutex = sem_open("/exam_load_mutex", 0);
+    bool ok = rubric_mutex != SEM_FAILED && reader_count_mutex != SEM_FAILED &&
+              exam_load_mutex != SEM_FAILED &&
+              open_slot_semaphores(exam_slots, false);
+    
+    if (!ok) {
+        std::cerr << "[SEM] Error: Could not open existing semaphores" << std::endl;
+    }
+    return ok;
+}
+
 // Close and remove all semaphores
 bool SemaphoreManager::cleanup() {
     std::cout << "[SEM] Cleaning up semaphores..." << std::endl;
@@ -103,18 +182,27 @@ bool SemaphoreManager::cleanup() {
         sem_unlink("/exam_load_mutex");
     }
     
-    for (int i = 0; i < 5; i++) {
+    for (size_t i = 0; i < question_mutexes.size(); i++) {
         if (question_mutexes[i] != SEM_FAILED) {
             char sem_name[50];
-            snprintf(sem_name, sizeof(sem_name), "/question_mutex_%d", i);
+            snprintf(sem_name, sizeof(sem_name), "/question_mutex_%d", (int)i);
             sem_close(question_mutexes[i]);
             sem_unlink(sem_name);
         }
     }
     
-    if (reader_count != nullptr) {
-        shmdt(reader_count);
-        reader_count = nullptr;
+    for (size_t i = 0; i < slot_mutexes.size(); i++) {
+        if (slot_mutexes[i] != SEM_FAILED) {
+            char sem_name[50];
+            snprintf(sem_name, sizeof(sem_name), "/exam_slot_mutex_%d", (int)i);
+            sem_close(slot_mutexes[i]);
+            sem_unlink(sem_name);
+        }
+    }
+    
+    if (lock_data != nullptr) {
+        shmdt(lock_data);
+        lock_data = nullptr;
     }
     
     if (shm_id_reader_count != -1) {
@@ -125,21 +213,63 @@ bool SemaphoreManager::cleanup() {
     return true;
 }
 
+static uint64_t now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Add one lock wait to a histogram without taking any lock
+static void record_wait(uint64_t* hist, uint64_t* max_wait, uint64_t wait_us) {
+    int bucket = 0;
+    while (bucket < LOCK_HIST_BUCKETS - 1 && (wait_us >> bucket) > 0) {
+        bucket++;
+    }
+    __atomic_fetch_add(&hist[bucket], 1, __ATOMIC_RELAXED);
+    
+    uint64_t seen = __atomic_load_n(max_wait, __ATOMIC_RELAXED);
+    while (wait_us > seen &&
+           !__atomic_compare_exchange_n(max_wait, &seen, wait_us, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Take a ticket and sleep on now_serving until it comes up. A POSIX
+// semaphore wakes waiters in no particular order, so it cannot promise that
+// readers arriving after a writer stay behind it; tickets do.
+void SemaphoreManager::enter_turnstile() {
+    uint32_t ticket = __atomic_fetch_add(&lock_data->next_ticket, 1, __ATOMIC_RELAXED);
+    uint32_t serving;
+    while ((serving = __atomic_load_n(&lock_data->now_serving, __ATOMIC_ACQUIRE)) != ticket) {
+        syscall(SYS_futex, &lock_data->now_serving, FUTEX_WAIT, serving, nullptr, nullptr, 0);
+    }
+}
+
+// Let the next ticket through. Waiters sleep on one word, so wake them all
+// and let the holder of the next ticket proceed.
+void SemaphoreManager::leave_turnstile() {
+    __atomic_fetch_add(&lock_data->now_serving, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &lock_data->now_serving, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
 // Readers-Writers: Acquire read access (multiple readers allowed)
 void SemaphoreManager::start_read_rubric() {
+    uint64_t start = now_us();
+    enter_turnstile();           // Wait behind any writer already queued
     sem_wait(reader_count_mutex);
-    (*reader_count)++;
-    if (*reader_count == 1) {
+    lock_data->reader_count++;
+    if (lock_data->reader_count == 1) {
         sem_wait(rubric_mutex);  // First reader locks out writers
     }
     sem_post(reader_count_mutex);
+    leave_turnstile();
+    record_wait(lock_data->read_wait_hist, &lock_data->max_read_wait_us, now_us() - start);
 }
 
 // Readers-Writers: Release read access
 void SemaphoreManager::end_read_rubric() {
     sem_wait(reader_count_mutex);
-    (*reader_count)--;
-    if (*reader_count == 0) {
+    lock_data->reader_count--;
+    if (lock_data->reader_count == 0) {
         sem_post(rubric_mutex);  // Last reader allows writers
     }
     sem_post(reader_count_mutex);
@@ -147,7 +277,11 @@ void SemaphoreManager::end_read_rubric() {
 
 // Readers-Writers: Acquire write access (exclusive)
 void SemaphoreManager::start_write_rubric() {
-    sem_wait(rubric_mutex);
+    uint64_t start = now_us();
+    enter_turnstile();           // Holding the turnstile stops new readers
+    sem_wait(rubric_mutex);      // Wait for the readers already inside
+    leave_turnstile();
+    record_wait(lock_data->write_wait_hist, &lock_data->max_write_wait_us, now_us() - start);
 }
 
 // Readers-Writers: Release write access
@@ -155,18 +289,59 @@ void SemaphoreManager::end_write_rubric() {
     sem_post(rubric_mutex);
 }
 
+// Percentile from a power-of-two histogram, reported as the bucket's upper bound
+static uint64_t hist_percentile(const uint64_t* hist, uint64_t total, double fraction) {
+    uint64_t target = (uint64_t)(total * fraction + 0.5);
+    uint64_t seen = 0;
+    for (int i = 0; i < LOCK_HIST_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= target && seen > 0) {
+            return (uint64_t)1 << i;
+        }
+    }
+    return (uint64_t)1 << (LOCK_HIST_BUCKETS - 1);
+}
+
+static void print_hist(const char* role, const uint64_t* hist, uint64_t max_wait) {
+    uint64_t total = 0;
+    for (int i = 0; i < LOCK_HIST_BUCKETS; i++) {
+        total += hist[i];
+    }
+    
+    std::cout << "  " << role << ": " << total << " acquisitions";
+    if (total == 0) {
+        std::cout << std::endl;
+        return;
+    }
+    std::cout << ", p50 < " << hist_percentile(hist, total, 0.50) << " us"
+              << ", p99 < " << hist_percentile(hist, total, 0.99) << " us"
+              << ", max " << max_wait << " us" << std::endl;
+    
+    for (int i = 0; i < LOCK_HIST_BUCKETS; i++) {
+        if (hist[i] > 0) {
+            std::cout << "    < " << ((uint64_t)1 << i) << " us: " << hist[i] << std::endl;
+        }
+    }
+}
+
+void SemaphoreManager::print_lock_stats() {
+    std::cout << "\nRubric lock wait times:" << std::endl;
+    print_hist("Readers", lock_data->read_wait_hist, lock_data->max_read_wait_us);
+    print_hist("Writers", lock_data->write_wait_hist, lock_data->max_write_wait_us);
+}
+
 // Try to claim a question for marking (non-blocking)
-bool SemaphoreManager::try_mark_question(int question_num) {
-    if (question_num < 0 || question_num >= 5) {
+bool SemaphoreManager::try_mark_question(int question_num, int slot) {
+    if (question_num < 0 || question_num >= 5 || slot < 0 || slot * 5 >= (int)question_mutexes.size()) {
         return false;
     }
-    return (sem_trywait(question_mutexes[question_num]) == 0);
+    return (sem_trywait(question_mutexes[slot * 5 + question_num]) == 0);
 }
 
 // Release a question after marking
-void SemaphoreManager::finish_mark_question(int question_num) {
-    if (question_num >= 0 && question_num < 5) {
-        sem_post(question_mutexes[question_num]);
+void SemaphoreManager::finish_mark_question(int question_num, int slot) {
+    if (question_num >= 0 && question_num < 5 && slot >= 0 && slot * 5 < (int)question_mutexes.size()) {
+        sem_post(question_mutexes[slot * 5 + question_num]);
     }
 }
 
@@ -178,4 +353,18 @@ void SemaphoreManager::lock_exam_load() {
 // Release exam loading access
 void SemaphoreManager::unlock_exam_load() {
     sem_post(exam_load_mutex);
-}
\ No newline at end of file
+}
+
+// Acquire exclusive access to one slot's exam
+void SemaphoreManager::lock_exam_slot(int slot) {
+    if (slot >= 0 && slot < (int)slot_mutexes.size()) {
+        sem_wait(slot_mutexes[slot]);
+    }
+}
+
+// Release one slot's exam
+void SemaphoreManager::unlock_exam_slot(int slot) {
+    if (slot >= 0 && slot < (int)slot_mutexes.size()) {
+        sem_post(slot_mutexes[slot]);
+    }
+}
@@ -2,45 +2,82 @@
 #define SEMAPHORE_MANAGER_H
 
 #include <semaphore.h>
+#include <cstdint>
 #include <string>
+#include <vector>
+
+const int LOCK_HIST_BUCKETS = 24;  // Bucket i holds waits below 2^i microseconds
+
+// Readers-writers state and lock-wait histograms (in shared memory)
+struct RubricLockData {
+    int reader_count;
+    uint32_t next_ticket;       // Turnstile: ticket handed to the next arrival
+    uint32_t now_serving;       // Turnstile: ticket allowed through
+    uint64_t read_wait_hist[LOCK_HIST_BUCKETS];
+    uint64_t write_wait_hist[LOCK_HIST_BUCKETS];
+    uint64_t max_read_wait_us;
+    uint64_t max_write_wait_us;
+};
 
 class SemaphoreManager {
 private:
     // Semaphores for rubric access 
     sem_t* rubric_mutex;        // Protects rubric writes
     sem_t* reader_count_mutex;  // Protects reader_count variable
-    int* reader_count;          // Number of processes reading rubric (in shared memory)
-    int shm_id_reader_count;    // Shared memory ID for reader_count
+    RubricLockData* lock_data;  // reader_count, turnstile and wait histograms (in shared memory)
+    int shm_id_reader_count;    // Shared memory ID for lock_data
     
     // Semaphore for exam loading
     sem_t* exam_load_mutex;     // Only one TA can load next exam
     
-    // Semaphores for question marking (one per question)
-    sem_t* question_mutexes[5]; // Prevent multiple TAs marking same question
+    // Semaphores for question marking (one per question of each active exam)
+    std::vector<sem_t*> question_mutexes;  // Prevent multiple TAs marking same question
+    std::vector<sem_t*> slot_mutexes;      // Guard completing or replacing one slot's exam
+    
+    bool open_slot_semaphores(int exam_slots, bool create);
+    
+    // Ticket turnstile in lock_data: passed strictly in arrival order, so a
+    // waiting writer stops new readers
+    void enter_turnstile();
+    void leave_turnstile();
     
 public:
     SemaphoreManager();
     ~SemaphoreManager();
     
-    // Initialize all semaphores
-    bool initialize();
+    // Initialize all semaphores; exam_slots is the number of exams marked at once
+    bool initialize(int exam_slots = 1);
     
     // Clean up all semaphores
     bool cleanup();
     
-    // Readers-Writers for rubric access
+    // Open the semaphores created by initialize() in another process
+    // (a spawned TA). Nothing is created or reset; do not call cleanup().
+    bool attach(int exam_slots = 1);
+    
+    // Readers-Writers for rubric access. Readers and writers both pass the
+    // ticket turnstile in arrival order, so a writer waits at most for the
+    // readers already inside, and readers arriving after it wait for one write.
     void start_read_rubric();   // Call before reading rubric
     void end_read_rubric();     // Call after reading rubric
     void start_write_rubric();  // Call before writing rubric
     void end_write_rubric();    // Call after writing rubric
     
-    // Question marking coordination
-    bool try_mark_question(int question_num);     // Try to claim a question
-    void finish_mark_question(int question_num);  // Release question after marking
+    // Question marking coordination, per exam slot
+    bool try_mark_question(int question_num, int slot = 0);     // Try to claim a question
+    void finish_mark_question(int question_num, int slot = 0);  // Release question after marking
+    
+    // Print reader and writer lock-wait histograms
+    void print_lock_stats();
     
     // Exam loading coordination
     void lock_exam_load();      // Call before loading next exam
     void unlock_exam_load();    // Call after loading next exam
+    
+    // Per-slot exam lock: held to complete a question or to replace the
+    // slot's exam, so finishing one slot never waits on another
+    void lock_exam_slot(int slot = 0);
+    void unlock_exam_slot(int slot = 0);
 };
 
 #endif
\ No newline at end of file
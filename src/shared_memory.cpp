@@ -4,9 +4,11 @@
 #include <sys/shm.h>
 #include <iostream>
 #include <cstring>
+#include <map>
 
-SharedMemory::SharedMemory() : shm_id_exam(-1), shm_id_rubric(-1), 
-                                 exam_data(nullptr), rubric_data(nullptr) {
+SharedMemory::SharedMemory() : shm_id_exam(-1), shm_id_rubric(-1), shm_id_exam_list(-1), shm_id_stats(-1),
+                                 exam_slot_count(1), exam_data(nullptr), rubric_data(nullptr), exam_list_data(nullptr),
+                                 stats_data(nullptr) {
 }
 
 SharedMemory::~SharedMemory() {
@@ -17,17 +19,31 @@ SharedMemory::~SharedMemory() {
     if (rubric_data != nullptr) {
         shmdt(rubric_data);
     }
+    if (exam_list_data != nullptr) {
+        shmdt(exam_list_data);
+    }
+    if (stats_data != nullptr) {
+        shmdt(stats_data);
+    }
 }
 
-bool SharedMemory::initialize() {
-    // Create shared memory for exam data
+bool SharedMemory::initialize(int exam_slots) {
+    // Create shared memory for exam data, one slot per active exam
     key_t exam_key = ftok(".", 'E');
     if (exam_key == -1) {
         std::cerr << "Error: ftok failed for exam" << std::endl;
         return false;
     }
     
-    shm_id_exam = shmget(exam_key, sizeof(ExamData), IPC_CREAT | 0666);
+    // Always start from a fresh segment; one left by a crashed run may have a
+    // different number of slots
+    int stale_id = shmget(exam_key, 0, 0);
+    if (stale_id != -1) {
+        shmctl(stale_id, IPC_RMID, nullptr);
+    }
+    
+    exam_slot_count = exam_slots;
+    shm_id_exam = shmget(exam_key, exam_slots * sizeof(ExamData), IPC_CREAT | 0666);
     if (shm_id_exam == -1) {
         std::cerr << "Error: shmget failed for exam" << std::endl;
         return false;
@@ -41,12 +57,20 @@ bool SharedMemory::initialize() {
     }
     
     // Initialize exam data
-    exam_data->student_number = 0;
-    exam_data->all_marked = false;
-    exam_data->current_exam_index = 0;
-    for (int i = 0; i < 5; i++) {
-        exam_data->questions_marked[i] = false;
-        exam_data->questions_being_marked[i] = -1;
+    for (int slot = 0; slot < exam_slots; slot++) {
+        ExamData* exam = &exam_data[slot];
+        exam->student_number = 0;
+        exam->all_marked = false;
+        exam->current_exam_index = 0;
+        exam->is_termination = false;
+        exam->loaded_us = 0;
+        exam->first_claim_us = 0;
+        for (int i = 0; i < 5; i++) {
+            exam->questions_marked[i] = false;
+            exam->questions_being_marked[i] = -1;
+            exam->question_done_us[i] = 0;
+            exam->claim_count[i] = 0;
+        }
     }
     
     // Create shared memory for rubric data
@@ -57,6 +81,14 @@ bool SharedMemory::initialize() {
     }
     
     shm_id_rubric = shmget(rubric_key, sizeof(RubricData), IPC_CREAT | 0666);
+    if (shm_id_rubric == -1) {
+        // A smaller segment left by a crashed run, replace it
+        int stale_id = shmget(rubric_key, 0, 0);
+        if (stale_id != -1) {
+            shmctl(stale_id, IPC_RMID, nullptr);
+            shm_id_rubric = shmget(rubric_key, sizeof(RubricData), IPC_CREAT | 0666);
+        }
+    }
     if (shm_id_rubric == -1) {
         std::cerr << "Error: shmget failed for rubric" << std::endl;
         return false;
@@ -70,14 +102,79 @@ bool SharedMemory::initialize() {
     }
     
     // Initialize rubric data
-    for (int i = 0; i < 5; i++) {
-        memset(rubric_data->rubric_text[i], 0, 100);
+    memset(rubric_data, 0, sizeof(RubricData));
+    
+    // Create shared memory for per-exam latency statistics
+    key_t stats_key = ftok(".", 'S');
+    if (stats_key == -1) {
+        std::cerr << "Error: ftok failed for exam stats" << std::endl;
+        return false;
     }
     
+    shm_id_stats = shmget(stats_key, sizeof(ExamStatsData), IPC_CREAT | 0666);
+    if (shm_id_stats == -1) {
+        // A smaller segment left by a crashed run, replace it
+        int stale_id = shmget(stats_key, 0, 0);
+        if (stale_id != -1) {
+            shmctl(stale_id, IPC_RMID, nullptr);
+            shm_id_stats = shmget(stats_key, sizeof(ExamStatsData), IPC_CREAT | 0666);
+        }
+    }
+    if (shm_id_stats == -1) {
+        std::cerr << "Error: shmget failed for exam stats" << std::endl;
+        return false;
+    }
+    
+    stats_data = (ExamStatsData*)shmat(shm_id_stats, nullptr, 0);
+    if (stats_data == (void*)-1) {
+        std::cerr << "Error: shmat failed for exam stats" << std::endl;
+        stats_data = nullptr;
+        return false;
+    }
+    memset(stats_data, 0, sizeof(ExamStatsData));
+    
     std::cout << "[SHARED_MEM] Initialized successfully" << std::endl;
     return true;
 }
 
+// Look up an existing segment by its ftok id and attach it
+static void* attach_existing(char id, int shm_flags, const char* name) {
+    key_t key = ftok(".", id);
+    int shm_id = (key == -1) ? -1 : shmget(key, 0, 0);
+    void* addr = (shm_id == -1) ? (void*)-1 : shmat(shm_id, nullptr, shm_flags);
+    if (addr == (void*)-1) {
+        std::cerr << "Error: Could not attach to " << name << " shared memory" << std::endl;
+        return nullptr;
+    }
+    return addr;
+}
+
+bool SharedMemory::attach(int exam_slots) {
+    exam_data = (ExamData*)attach_existing('E', 0, "exam");
+    rubric_data = (RubricData*)attach_existing('R', 0, "rubric");
+    stats_data = (ExamStatsData*)attach_existing('S', 0, "exam stats");
+    if (exam_data == nullptr || rubric_data == nullptr || stats_data == nullptr) {
+        return false;
+    }
+    
+    // The main process passes its slot count; check the segment really has them
+    struct shmid_ds info;
+    int shm_id = shmget(ftok(".", 'E'), 0, 0);
+    if (shm_id == -1 || shmctl(shm_id, IPC_STAT, &info) == -1 ||
+        info.shm_segsz < exam_slots * sizeof(ExamData)) {
+        std::cerr << "Error: Exam shared memory does not hold " << exam_slots << " exam slot(s)" << std::endl;
+        return false;
+    }
+    exam_slot_count = exam_slots;
+    
+    // The exam list is only there once the main process has published it
+    key_t list_key = ftok(".", 'L');
+    if (list_key != -1 && shmget(list_key, 0, 0) != -1) {
+        exam_list_data = (ExamListData*)attach_existing('L', SHM_RDONLY, "exam list");
+    }
+    return true;
+}
+
 bool SharedMemory::cleanup() {
     bool success = true;
     
@@ -98,6 +195,22 @@ bool SharedMemory::cleanup() {
         rubric_data = nullptr;
     }
     
+    if (exam_list_data != nullptr) {
+        if (shmdt(exam_list_data) == -1) {
+            std::cerr << "Error: shmdt failed for exam list" << std::endl;
+            success = false;
+        }
+        exam_list_data = nullptr;
+    }
+    
+    if (stats_data != nullptr) {
+        if (shmdt(stats_data) == -1) {
+            std::cerr << "Error: shmdt failed for exam stats" << std::endl;
+            success = false;
+        }
+        stats_data = nullptr;
+    }
+    
     // Remove shared memory segments
     if (shm_id_exam != -1) {
         if (shmctl(shm_id_exam, IPC_RMID, nullptr) == -1) {
@@ -113,33 +226,180 @@ bool SharedMemory::cleanup() {
         }
     }
     
+    if (shm_id_exam_list != -1) {
+        if (shmctl(shm_id_exam_list, IPC_RMID, nullptr) == -1) {
+            std::cerr << "Error: shmctl IPC_RMID failed for exam list" << std::endl;
+            success = false;
+        }
+    }
+    
+    if (shm_id_stats != -1) {
+        if (shmctl(shm_id_stats, IPC_RMID, nullptr) == -1) {
+            std::cerr << "Error: shmctl IPC_RMID failed for exam stats" << std::endl;
+            success = false;
+        }
+    }
+    
     std::cout << "[SHARED_MEM] Cleaned up" << std::endl;
     return success;
 }
 
-ExamData* SharedMemory::get_exam_data() {
-    return exam_data;
+ExamData* SharedMemory::get_exam_data(int slot) {
+    return &exam_data[slot];
+}
+
+int SharedMemory::get_exam_slot_count() const {
+    return exam_slot_count;
 }
 
 RubricData* SharedMemory::get_rubric_data() {
     return rubric_data;
 }
 
-bool SharedMemory::load_exam_from_file(int student_number, int exam_index) {
-    int student_num;
-    if (!FileManager::read_exam_file(student_number, student_num)) {
+ExamStatsData* SharedMemory::get_exam_stats() {
+    return stats_data;
+}
+
+bool SharedMemory::publish_exam_list(const std::vector<int64_t>& exams) {
+    key_t list_key = ftok(".", 'L');
+    if (list_key == -1) {
+        std::cerr << "Error: ftok failed for exam list" << std::endl;
         return false;
     }
     
-    exam_data->student_number = student_num;
-    exam_data->all_marked = false;
-    exam_data->current_exam_index = exam_index;
+    // Packed exams are published with their location, so spawned TAs read
+    // them without scanning the pack files again
+    const std::vector<std::string>& packs = FileManager::get_pack_files();
+    for (size_t i = 0; i < packs.size(); i++) {
+        if (packs[i].length() >= sizeof(ExamPackPath().path)) {
+            std::cerr << "Error: Exam pack path is too long: " << packs[i] << std::endl;
+            return false;
+        }
+    }
+    
+    size_t size = sizeof(ExamListData) + exams.size() * sizeof(ExamListEntry) +
+                  packs.size() * sizeof(ExamPackPath);
+    shm_id_exam_list = shmget(list_key, size, IPC_CREAT | 0666);
+    if (shm_id_exam_list == -1) {
+        // A segment left by a crashed run is too small for this list, replace it
+        int stale_id = shmget(list_key, 0, 0);
+        if (stale_id != -1) {
+            shmctl(stale_id, IPC_RMID, nullptr);
+            shm_id_exam_list = shmget(list_key, size, IPC_CREAT | 0666);
+        }
+    }
+    if (shm_id_exam_list == -1) {
+        std::cerr << "Error: shmget failed for exam list" << std::endl;
+        return false;
+    }
+    
+    // Fill the list through a writable mapping
+    ExamListData* list = (ExamListData*)shmat(shm_id_exam_list, nullptr, 0);
+    if (list == (void*)-1) {
+        std::cerr << "Error: shmat failed for exam list" << std::endl;
+        return false;
+    }
+    
+    // Priorities from the sidecar file travel with the list
+    std::map<int64_t, int32_t> priorities;
+    FileManager::read_priorities(priorities);
+    
+    ExamListEntry* entries = (ExamListEntry*)(list + 1);
+    list->count = exams.size();
+    list->pack_count = packs.size();
+    list->reserved = 0;
+    for (size_t i = 0; i < exams.size(); i++) {
+        entries[i].student_number = exams[i];
+        entries[i].file_size = FileManager::get_exam_file_size(exams[i]);
+        std::map<int64_t, int32_t>::const_iterator it = priorities.find(exams[i]);
+        entries[i].priority = (it == priorities.end()) ? 0 : it->second;
+        ExamLocation location;
+        bool packed = FileManager::get_pack_location(exams[i], location);
+        entries[i].pack_id = packed ? location.pack_id : -1;
+        entries[i].pack_offset = packed ? location.offset : 0;
+    }
+    ExamPackPath* pack_paths = (ExamPackPath*)(entries + exams.size());
+    for (size_t i = 0; i < packs.size(); i++) {
+        memset(pack_paths[i].path, 0, sizeof(pack_paths[i].path));
+        strncpy(pack_paths[i].path, packs[i].c_str(), sizeof(pack_paths[i].path) - 1);
+    }
+    shmdt(list);
+    
+    // TAs inherit this read-only attachment across fork()
+    exam_list_data = (ExamListData*)shmat(shm_id_exam_list, nullptr, SHM_RDONLY);
+    if (exam_list_data == (void*)-1) {
+        std::cerr << "Error: shmat failed for exam list" << std::endl;
+        exam_list_data = nullptr;
+        return false;
+    }
+    
+    std::cout << "[SHARED_MEM] Published exam list (" << exams.size() << " exams)" << std::endl;
+    return true;
+}
+
+int64_t SharedMemory::get_exam_count() const {
+    return exam_list_data != nullptr ? exam_list_data->count : 0;
+}
+
+const ExamListEntry* SharedMemory::get_exam_entry(int64_t index) const {
+    return (const ExamListEntry*)(exam_list_data + 1) + index;
+}
+
+const ExamListEntry* SharedMemory::find_exam_entry(int64_t student_number) const {
+    int64_t count = get_exam_count();
+    if (count == 0) {
+        return nullptr;
+    }
+    
+    // The list is sorted by student number, except the termination exam last
+    const ExamListEntry* entries = get_exam_entry(0);
+    if (entries[count - 1].student_number == student_number) {
+        return &entries[count - 1];
+    }
+    int64_t low = 0, high = count - 1;
+    while (low < high) {
+        int64_t mid = low + (high - low) / 2;
+        if (entries[mid].student_number < student_number) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low < count - 1 && entries[low].student_number == student_number) ? &entries[low] : nullptr;
+}
+
+const char* SharedMemory::get_pack_path(int pack_id) const {
+    const ExamPackPath* pack_paths = (const ExamPackPath*)(get_exam_entry(0) + exam_list_data->count);
+    return pack_paths[pack_id].path;
+}
+
+bool SharedMemory::load_exam_from_file(int64_t student_number, int exam_index, int slot) {
+    // Packed exams are read where the published list says they are
+    const ExamListEntry* entry = find_exam_entry(student_number);
+    bool packed = entry != nullptr && entry->pack_id >= 0;
+    int64_t student_num;
+    bool read = packed ? FileManager::read_packed_exam(get_pack_path(entry->pack_id), entry->pack_offset,
+                                                       (uint32_t)entry->file_size, student_num)
+                       : FileManager::read_exam_file(student_number, student_num);
+    if (!read) {
+        return false;
+    }
+    
+    ExamData* exam = &exam_data[slot];
+    exam->student_number = student_num;
+    exam->all_marked = false;
+    exam->current_exam_index = exam_index;
+    exam->is_termination = !packed && FileManager::is_termination_exam(student_number);
+    exam->first_claim_us = 0;
     
     // Reset all questions to unmarked
     for (int i = 0; i < 5; i++) {
-        exam_data->questions_marked[i] = false;
-        exam_data->questions_being_marked[i] = -1;
+        exam->questions_marked[i] = false;
+        exam->questions_being_marked[i] = -1;
+        exam->question_done_us[i] = 0;
+        exam->claim_count[i] = 0;
     }
+    exam->loaded_us = ExamStats::now_us();
     
     std::cout << "[SHARED_MEM] Loaded exam for student " << student_num << std::endl;
     return true;
@@ -149,15 +409,62 @@ bool SharedMemory::load_rubric_from_file() {
     if (!FileManager::read_rubric_file(rubric_data->rubric_text)) {
         return false;
     }
+    memcpy(rubric_data->file_text, rubric_data->rubric_text, sizeof(rubric_data->file_text));
     
     std::cout << "[SHARED_MEM] Loaded rubric from file" << std::endl;
     return true;
 }
 
 bool SharedMemory::save_rubric_to_file() {
+    // Keep edits made to the file since our last save instead of overwriting
+    // them; only Part B watches for such edits
+    if (rubric_data->watch_edits) {
+        merge_rubric_file_edits();
+    }
+    
     if (!FileManager::write_rubric_file(rubric_data->rubric_text)) {
         return false;
     }
+    memcpy(rubric_data->file_text, rubric_data->rubric_text, sizeof(rubric_data->file_text));
     
     return true;
-}
\ No newline at end of file
+}
+
+int SharedMemory::merge_rubric_file_edits() {
+    char on_disk[5][100];
+    memset(on_disk, 0, sizeof(on_disk));
+    if (!FileManager::read_rubric_file(on_disk)) {
+        return -1;
+    }
+    
+    // Only lines that differ from what we last wrote were edited externally;
+    // the other lines may hold newer corrections that are not saved yet
+    int changed = 0;
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(on_disk[i], rubric_data->file_text[i]) == 0) {
+            continue;
+        }
+        memcpy(rubric_data->file_text[i], on_disk[i], 100);
+        memcpy(rubric_data->rubric_text[i], on_disk[i], 100);
+        __atomic_fetch_add(&rubric_data->line_version[i], 1, __ATOMIC_ACQ_REL);
+        changed++;
+        
+        std::cout << "[SHARED_MEM] Rubric line " << (i + 1) << " edited externally: \""
+                  << on_disk[i] << "\" (version " << rubric_data->line_version[i] << ")" << std::endl;
+    }
+    return changed;
+}
+
+bool SharedMemory::rubric_file_edited() {
+    char on_disk[5][100];
+    memset(on_disk, 0, sizeof(on_disk));
+    if (!FileManager::read_rubric_file(on_disk)) {
+        return true;  // Let the locked merge report the error
+    }
+    for (int i = 0; i < 5; i++) {
+        if (strcmp(on_disk[i], rubric_data->file_text[i]) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
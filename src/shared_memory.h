@@ -1,41 +1,108 @@
 #ifndef SHARED_MEMORY_H
 #define SHARED_MEMORY_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
+#include "exam_stats.h"
 
-// Shared data structures
-struct ExamData {
-    int student_number;
+const int MAX_EXAM_SLOTS = 16;   // Exams marked at once with --active-exams
+
+// Shared data structures. With several active exams the slots sit side by
+// side, each on its own cache lines, so claims on one exam do not invalidate
+// the lines of another.
+struct alignas(64) ExamData {
+    int64_t student_number;
     bool questions_marked[5];     // Track which questions are marked
     int questions_being_marked[5]; // TA ID marking each question (-1 if none)
     bool all_marked;              // Flag to indicate all questions are done
     int current_exam_index;       // Index in exam list
+    bool is_termination;          // Loaded exam is the legacy exam_9999.txt marker
+    uint64_t loaded_us;           // ExamStats::now_us() when the exam was loaded
+    uint64_t first_claim_us;      // When the first question was claimed (0 if none yet)
+    uint64_t question_done_us[5]; // When each question was marked (0 if not yet)
+    uint32_t claim_count[5];      // Claims per question, kept by the race detector
+};
+
+// One entry of the exam list shared read-only by all TAs
+struct ExamListEntry {
+    int64_t student_number;
+    int64_t file_size;         // Bytes of exam text
+    int32_t priority;          // Higher is marked sooner, 0 by default
+    int32_t pack_id;           // Pack the exam is stored in (-1 if it is a file)
+    int64_t pack_offset;       // Byte offset of the exam text inside that pack
+};
+
+// Path of a pack file, looked up by ExamListEntry::pack_id
+struct ExamPackPath {
+    char path[256];
+};
+
+// Header of the shared exam list; `count` entries follow it directly, then
+// `pack_count` pack paths
+struct ExamListData {
+    int64_t count;
+    int32_t pack_count;
+    int32_t reserved;
 };
 
 struct RubricData {
     char rubric_text[5][100];  // 5 questions, up to 100 chars each
+    char file_text[5][100];    // The rubric file as last loaded or saved by us
+    uint64_t line_version[5];  // Bumped (atomically) whenever a line is written
+    bool watch_edits;          // Part B is watching the file; saves merge external edits
 };
 
 class SharedMemory {
 private:
     int shm_id_exam;
     int shm_id_rubric;
-    ExamData* exam_data;
+    int shm_id_exam_list;
+    int shm_id_stats;
+    int exam_slot_count;
+    ExamData* exam_data;            // exam_slot_count slots
     RubricData* rubric_data;
+    ExamListData* exam_list_data;
+    ExamStatsData* stats_data;
     
 public:
     SharedMemory();
     ~SharedMemory();
     
-    bool initialize();
+    bool initialize(int exam_slots = 1);
     bool cleanup();
     
-    ExamData* get_exam_data();
+    // Attach to the segments created by initialize(exam_slots) in another
+    // process (a spawned TA). The segments are left as they are; do not call cleanup().
+    bool attach(int exam_slots = 1);
+    
+    ExamData* get_exam_data(int slot = 0);
+    int get_exam_slot_count() const;
     RubricData* get_rubric_data();
+    ExamStatsData* get_exam_stats();
+    
+    // Copy the exam list into a segment that is attached read-only afterwards,
+    // so forked TAs share one copy instead of each holding a vector
+    bool publish_exam_list(const std::vector<int64_t>& exams);
+    int64_t get_exam_count() const;
+    const ExamListEntry* get_exam_entry(int64_t index) const;
     
-    bool load_exam_from_file(int student_number, int exam_index);
+    // Entry of a student in the published list, nullptr if it is not listed
+    const ExamListEntry* find_exam_entry(int64_t student_number) const;
+    const char* get_pack_path(int pack_id) const;
+    
+    bool load_exam_from_file(int64_t student_number, int exam_index, int slot = 0);
     bool load_rubric_from_file();
     bool save_rubric_to_file();
+    
+    // Copy lines edited in the rubric file by someone else (they differ from
+    // file_text) into the shared rubric. Part B calls this under the rubric
+    // writer lock. Returns the number of lines changed, or -1 on a read error.
+    int merge_rubric_file_edits();
+    
+    // Lock-free pre-check for merge_rubric_file_edits(): false when the file
+    // still holds what a TA last saved, so the TA's own saves are ignored
+    bool rubric_file_edited();
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,219 @@
+// sim_engine.cpp
+// Executor pool, timers and readers-writers lock for coroutine TAs
+
+#include "sim_engine.h"
+#include <cstdlib>
+#include <iostream>
+
+void SimTask::promise_type::return_void() {
+    engine->task_finished();
+}
+
+void SimTask::promise_type::unhandled_exception() {
+    std::cerr << "[SIM] Unhandled exception in simulated TA" << std::endl;
+    std::abort();
+}
+
+SimTask::SimTask(SimTask&& other) noexcept : handle(other.handle) {
+    other.handle = nullptr;
+}
+
+SimTask::~SimTask() {
+    // Only a task that was never spawned is still owned here
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> h) {
+    engine->schedule_after(h, seconds);
+}
+
+SimEngine::SimEngine(int threads, double scale)
+    : num_threads(threads), time_scale(scale), start_time(Clock::now()),
+      timer_seq(0), live_tasks(0), resumes(0) {
+}
+
+void SimEngine::spawn(SimTask task) {
+    task.handle.promise().engine = this;
+    std::coroutine_handle<> h = task.handle;
+    task.handle = nullptr;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    live_tasks++;
+    ready.push_back(h);
+}
+
+void SimEngine::schedule(std::coroutine_handle<> h) {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        ready.push_back(h);
+    }
+    wakeup.notify_one();
+}
+
+void SimEngine::schedule_after(std::coroutine_handle<> h, double seconds) {
+    Clock::duration delay = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds * time_scale));
+
+    std::lock_guard<std::mutex> guard(mutex);
+    Timer timer;
+    timer.deadline = Clock::now() + delay;
+    timer.seq = timer_seq++;
+    timer.handle = h;
+    timers.push(timer);
+    // An idle thread may be sleeping until a later deadline
+    wakeup.notify_one();
+}
+
+void SimEngine::task_finished() {
+    std::lock_guard<std::mutex> guard(mutex);
+    live_tasks--;
+    if (live_tasks == 0) {
+        wakeup.notify_all();
+    }
+}
+
+double SimEngine::now() const {
+    std::chrono::duration<double> elapsed = Clock::now() - start_time;
+    return elapsed.count() / time_scale;
+}
+
+void SimEngine::worker_loop() {
+    std::unique_lock<std::mutex> guard(mutex);
+
+    while (true) {
+        // Move every expired timer onto the ready queue
+        Clock::time_point now = Clock::now();
+        while (!timers.empty() && timers.top().deadline <= now) {
+            ready.push_back(timers.top().handle);
+            timers.pop();
+        }
+
+        if (!ready.empty()) {
+            std::coroutine_handle<> h = ready.front();
+            ready.pop_front();
+            resumes++;
+            guard.unlock();
+            h.resume();
+            guard.lock();
+            continue;
+        }
+
+        if (live_tasks == 0) {
+            break;
+        }
+
+        if (timers.empty()) {
+            wakeup.wait(guard);
+        } else {
+            wakeup.wait_until(guard, timers.top().deadline);
+        }
+    }
+}
+
+void SimEngine::run() {
+    start_time = Clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; i++) {
+        threads.push_back(std::thread(&SimEngine::worker_loop, this));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+AsyncRWLock::AsyncRWLock(SimEngine* eng)
+    : engine(eng), readers(0), writer_active(false),
+      read_stats(), write_stats() {
+}
+
+bool AsyncRWLock::try_acquire(bool writer) {
+    // Anyone already queued goes first
+    if (writer_active || !waiters.empty()) {
+        return false;
+    }
+    if (writer) {
+        if (readers > 0) {
+            return false;
+        }
+        writer_active = true;
+    } else {
+        readers++;
+    }
+    LockWaitStats& stats = writer ? write_stats : read_stats;
+    stats.acquisitions++;
+    return true;
+}
+
+void AsyncRWLock::enqueue(std::coroutine_handle<> h, bool writer) {
+    Waiter waiter;
+    waiter.handle = h;
+    waiter.writer = writer;
+    waiter.enqueued = engine->now();
+    waiters.push_back(waiter);
+}
+
+bool AsyncRWLock::Awaiter::await_suspend(std::coroutine_handle<> h) {
+    std::lock_guard<std::mutex> guard(lock->mutex);
+    if (lock->try_acquire(writer)) {
+        return false;               // Acquired without suspending
+    }
+    lock->enqueue(h, writer);
+    return true;
+}
+
+// Hand the lock to the front of the queue: one writer, or every reader up to
+// the next queued writer. Called with `mutex` held.
+void AsyncRWLock::wake_waiters() {
+    double now = engine->now();
+
+    while (!waiters.empty() && !writer_active) {
+        Waiter& front = waiters.front();
+        if (front.writer && readers > 0) {
+            break;
+        }
+
+        LockWaitStats& stats = front.writer ? write_stats : read_stats;
+        double waited = now - front.enqueued;
+        stats.acquisitions++;
+        stats.waits++;
+        stats.total_wait += waited;
+        if (waited > stats.max_wait) {
+            stats.max_wait = waited;
+        }
+
+        if (front.writer) {
+            writer_active = true;
+        } else {
+            readers++;
+        }
+        engine->schedule(front.handle);
+        waiters.pop_front();
+    }
+}
+
+void AsyncRWLock::unlock_shared() {
+    std::lock_guard<std::mutex> guard(mutex);
+    readers--;
+    if (readers == 0) {
+        wake_waiters();
+    }
+}
+
+void AsyncRWLock::unlock() {
+    std::lock_guard<std::mutex> guard(mutex);
+    writer_active = false;
+    wake_waiters();
+}
+
+LockWaitStats AsyncRWLock::get_read_stats() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return read_stats;
+}
+
+LockWaitStats AsyncRWLock::get_write_stats() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return write_stats;
+}
@@ -0,0 +1,155 @@
+#ifndef SIM_ENGINE_H
+#define SIM_ENGINE_H
+
+// Coroutine engine for simulating many TAs in one process (needs -std=c++20).
+// Each TA is a SimTask run by a small pool of executor threads; sleeps are
+// timers, so a waiting TA costs a heap entry instead of a process.
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class SimEngine;
+
+// Fire-and-forget coroutine; it starts when spawned and frees itself when done
+class SimTask {
+public:
+    struct promise_type {
+        SimEngine* engine = nullptr;
+
+        SimTask get_return_object() {
+            return SimTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void();
+        void unhandled_exception();
+    };
+
+    SimTask(SimTask&& other) noexcept;
+    ~SimTask();
+
+private:
+    friend class SimEngine;
+    explicit SimTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+// co_await engine.sleep_for(seconds)
+struct SleepAwaiter {
+    SimEngine* engine;
+    double seconds;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h);
+    void await_resume() const noexcept {}
+};
+
+class SimEngine {
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t seq;               // Keeps equal deadlines in FIFO order
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : seq > other.seq;
+        }
+    };
+
+    int num_threads;
+    double time_scale;              // Real seconds per simulated second
+    Clock::time_point start_time;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<std::coroutine_handle<> > ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer> > timers;
+    uint64_t timer_seq;
+    int64_t live_tasks;
+    uint64_t resumes;
+
+    void worker_loop();
+
+public:
+    SimEngine(int threads, double scale);
+
+    // Queue a task to start on the next free executor thread
+    void spawn(SimTask task);
+
+    // Run until every spawned task has finished
+    void run();
+
+    SleepAwaiter sleep_for(double seconds) { return SleepAwaiter{this, seconds}; }
+
+    // Make a suspended coroutine runnable now / after `seconds` simulated seconds
+    void schedule(std::coroutine_handle<> h);
+    void schedule_after(std::coroutine_handle<> h, double seconds);
+
+    void task_finished();
+
+    double now() const;             // Simulated seconds since run() started
+    uint64_t get_resumes() const { return resumes; }
+    int get_num_threads() const { return num_threads; }
+};
+
+// Wait statistics for one side of the AsyncRWLock, in simulated seconds
+struct LockWaitStats {
+    uint64_t acquisitions;
+    uint64_t waits;                 // Acquisitions that had to queue
+    double total_wait;
+    double max_wait;
+};
+
+// Fair readers-writers lock for coroutines. Like the Part B turnstile, a
+// queued writer stops readers that arrive after it; waiters are woken in
+// FIFO order, a run of consecutive readers together.
+class AsyncRWLock {
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        bool writer;
+        double enqueued;
+    };
+
+    SimEngine* engine;
+    std::mutex mutex;
+    int readers;
+    bool writer_active;
+    std::deque<Waiter> waiters;
+    LockWaitStats read_stats;
+    LockWaitStats write_stats;
+
+    bool try_acquire(bool writer);
+    void enqueue(std::coroutine_handle<> h, bool writer);
+    void wake_waiters();
+
+public:
+    struct Awaiter {
+        AsyncRWLock* lock;
+        bool writer;
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h);
+        void await_resume() const noexcept {}
+    };
+
+    explicit AsyncRWLock(SimEngine* eng);
+
+    Awaiter lock_shared() { return Awaiter{this, false}; }
+    Awaiter lock() { return Awaiter{this, true}; }
+    void unlock_shared();
+    void unlock();
+
+    LockWaitStats get_read_stats();
+    LockWaitStats get_write_stats();
+};
+
+#endif
@@ -0,0 +1,50 @@
+// ta_launcher.cpp
+// posix_spawn launch of TA worker processes and startup timing
+
+#include "ta_launcher.h"
+#include "exam_stats.h"
+#include <iostream>
+#include <spawn.h>
+#include <unistd.h>
+
+extern char** environ;
+
+const std::string TALauncher::WORKER_BINARY = "main_ta_101300683_101310636";
+
+TALauncher::TALauncher(const char* parent_argv0, const std::vector<std::string>& args)
+    : worker_args(args) {
+    std::string parent = parent_argv0;
+    size_t slash = parent.rfind('/');
+    worker_path = (slash == std::string::npos ? std::string("./") : parent.substr(0, slash + 1)) + WORKER_BINARY;
+}
+
+pid_t TALauncher::spawn_ta(int ta_id) {
+    std::string id = std::to_string(ta_id);
+    std::vector<char*> argv;
+    argv.push_back((char*)worker_path.c_str());
+    argv.push_back((char*)id.c_str());
+    for (size_t i = 0; i < worker_args.size(); i++) {
+        argv.push_back((char*)worker_args[i].c_str());
+    }
+    argv.push_back(nullptr);
+
+    // glibc's posix_spawn uses a vfork-style clone, nothing of the parent is copied
+    pid_t pid;
+    int err = posix_spawn(&pid, worker_path.c_str(), nullptr, nullptr, argv.data(), environ);
+    if (err != 0) {
+        std::cerr << "Error: Could not spawn " << worker_path << " (errno " << err << ")" << std::endl;
+        return -1;
+    }
+    return pid;
+}
+
+double TALauncher::wait_until_ready(ExamStatsData* stats, int count, uint64_t start_us, int timeout_ms) {
+    uint64_t deadline = start_us + (uint64_t)timeout_ms * 1000;
+    while (__atomic_load_n(&stats->tas_ready, __ATOMIC_ACQUIRE) < (uint64_t)count) {
+        if (ExamStats::now_us() > deadline) {
+            return -1;
+        }
+        usleep(1000); // 1 ms
+    }
+    return (__atomic_load_n(&stats->last_ready_us, __ATOMIC_RELAXED) - start_us) / 1000.0;
+}
@@ -0,0 +1,33 @@
+#ifndef TA_LAUNCHER_H
+#define TA_LAUNCHER_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ExamStatsData;
+
+// Starts TAs as separate executables with posix_spawn instead of fork(), so
+// launch cost does not grow with the parent's heap. The worker binary
+// attaches to the shared memory and semaphores the parent already created.
+class TALauncher {
+private:
+    std::string worker_path;
+    std::vector<std::string> worker_args;   // Passed after the TA id
+
+public:
+    static const std::string WORKER_BINARY;
+
+    // parent_argv0 locates the worker binary next to the running program
+    TALauncher(const char* parent_argv0, const std::vector<std::string>& args);
+
+    // Returns the child's pid, or -1 if it could not be started
+    pid_t spawn_ta(int ta_id);
+
+    // Wait until `count` TAs have reported ready. Returns milliseconds from
+    // start_us to the last one, or -1 after timeout_ms.
+    static double wait_until_ready(ExamStatsData* stats, int count, uint64_t start_us, int timeout_ms);
+};
+
+#endif
@@ -1,20 +1,35 @@
 #include "ta_process.h"
 #include "file_manager.h"
+#include "semaphore_manager.h"
+#include "exam_queue.h"
+#include "exam_stats.h"
+#include "workload_profile.h"
+#include "race_detector.h"
 #include <iostream>
+#include <cstring>
 #include <unistd.h>
 #include <cstdlib>
 #include <ctime>
+#include <algorithm>
 
-// Constructor for Part B with semaphores
-TAProcess::TAProcess(int id, SharedMemory* shm, const std::vector<int>& exams, SemaphoreManager* sem) 
-    : ta_id(id), shared_mem(shm), exam_list(exams) {
+// Used until set_workload() is called
+static const WorkloadProfile default_workload;
+
+// Constructor; sem is nullptr for Part A
+TAProcess::TAProcess(int id, SharedMemory* shm, SemaphoreManager* sem) 
+    : ta_id(id), shared_mem(shm), sem_manager(sem), exam_queue(nullptr),
+      workload(&default_workload), duplicate_claim(false), current_slot(0),
+      load_failed(false) {
     // Seed random number generator with TA ID and time
-    srand(time(nullptr) + ta_id);
+    rng.seed(time(nullptr) + ta_id);
+}
+
+void TAProcess::set_exam_queue(ExamQueue* queue) {
+    exam_queue = queue;
 }
 
-double TAProcess::get_random_delay(double min, double max) {
-    double random = (double)rand() / RAND_MAX;
-    return min + random * (max - min);
+void TAProcess::set_workload(const WorkloadProfile* profile) {
+    workload = profile;
 }
 
 void TAProcess::review_and_correct_rubric() {
@@ -24,140 +39,405 @@ void TAProcess::review_and_correct_rubric() {
     
     // Review each of the 5 questions
     for (int q = 0; q < 5; q++) {
-        double delay = get_random_delay(0.5, 1.0);
+        // Part B: readers share the rubric while reviewing a line
+        if (sem_manager != nullptr) {
+            sem_manager->start_read_rubric();
+        }
+        
+        double delay = workload->review_time(q, rng);
         usleep(delay * 1000000); // Convert to microseconds
         
-        // Randomly decide if correction is needed (30% chance)
-        bool needs_correction = (rand() % 100) < 30;
+        // Randomly decide if correction is needed (30% chance by default)
+        bool needs_correction = workload->needs_correction(q, rng);
+        
+        if (sem_manager != nullptr) {
+            sem_manager->end_read_rubric();
+        }
         
         if (needs_correction) {
             std::cout << "[TA " << ta_id << "] Detected error in rubric for question " 
                       << (q + 1) << ", correcting..." << std::endl;
             
-            // Find the character after the comma
-            std::string line = rubric->rubric_text[q];
-            size_t comma_pos = line.find(',');
+            // Part B: corrections are exclusive, the line is re-read under the lock
+            if (sem_manager != nullptr) {
+                sem_manager->start_write_rubric();
+            }
             
-            if (comma_pos != std::string::npos && comma_pos + 2 < line.length()) {
-                char current_char = line[comma_pos + 2];
-                char next_char = current_char + 1;
-                
-                // Replace the character
-                line[comma_pos + 2] = next_char;
-                
-                // Copy back to shared memory
-                strncpy(rubric->rubric_text[q], line.c_str(), 99);
-                rubric->rubric_text[q][99] = '\0';
-                
+            char current_char, next_char;
+            bool overwrote = false;
+            if (correct_rubric_line(rubric, q, current_char, next_char, &overwrote)) {
+                RaceDetector::record_correction(&shared_mem->get_exam_stats()->races, q, overwrote);
                 std::cout << "[TA " << ta_id << "] Changed rubric Q" << (q + 1) 
                           << " from '" << current_char << "' to '" << next_char << "'" << std::endl;
                 
-                // Save to file (Race Condition Expected)
+                // Save to file (Race Condition Expected in Part A)
                 shared_mem->save_rubric_to_file();
                 std::cout << "[TA " << ta_id << "] Saved rubric changes to file" << std::endl;
             }
+            
+            if (sem_manager != nullptr) {
+                sem_manager->end_write_rubric();
+            }
         }
     }
     
     std::cout << "[TA " << ta_id << "] Finished reviewing rubric" << std::endl;
 }
 
+bool TAProcess::correct_rubric_line(RubricData* rubric, int question_num, char& from, char& to,
+                                    bool* overwrote) {
+    // Find the character after the comma
+    std::string line = rubric->rubric_text[question_num];
+    std::string read_line = line;
+    size_t comma_pos = line.find(',');
+    
+    if (comma_pos == std::string::npos || comma_pos + 2 >= line.length()) {
+        return false;
+    }
+    
+    from = line[comma_pos + 2];
+    to = from + 1;
+    
+    // Replace the character
+    line[comma_pos + 2] = to;
+    
+    // A line that no longer holds what we read was changed by another write,
+    // and copying ours over it loses that update
+    if (overwrote != nullptr) {
+        *overwrote = read_line != rubric->rubric_text[question_num];
+    }
+    
+    // Copy back to shared memory
+    strncpy(rubric->rubric_text[question_num], line.c_str(), 99);
+    rubric->rubric_text[question_num][99] = '\0';
+    __atomic_fetch_add(&rubric->line_version[question_num], 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool TAProcess::claim_question(ExamData* exam, int question_num, int ta_id) {
+    if (exam->questions_marked[question_num] || exam->questions_being_marked[question_num] != -1) {
+        return false;
+    }
+    exam->questions_being_marked[question_num] = ta_id;
+    return true;
+}
+
+bool TAProcess::complete_question(ExamData* exam, int question_num) {
+    exam->questions_marked[question_num] = true;
+    exam->questions_being_marked[question_num] = -1;
+    
+    // Check if all questions are marked
+    for (int i = 0; i < 5; i++) {
+        if (!exam->questions_marked[i]) {
+            return false;
+        }
+    }
+    
+    // Two TAs can finish the last questions together; only one completes the exam
+    return !__atomic_exchange_n(&exam->all_marked, true, __ATOMIC_ACQ_REL);
+}
+
 int TAProcess::select_question_to_mark() {
-    ExamData* exam = shared_mem->get_exam_data();
+    ExamData* exam = shared_mem->get_exam_data(current_slot);
+    RaceCounters* races = &shared_mem->get_exam_stats()->races;
     
     // Find an unmarked question
     for (int q = 0; q < 5; q++) {
         if (!exam->questions_marked[q] && exam->questions_being_marked[q] == -1) {
-            // Mark as being marked by this TA (Race Condtion expected)
-            exam->questions_being_marked[q] = ta_id;
-            return q;
+            if (sem_manager == nullptr) {
+                // Mark as being marked by this TA (Race Condtion expected)
+                claim_question(exam, q, ta_id);
+                duplicate_claim = RaceDetector::record_claim(races, exam, q);
+                if (exam->first_claim_us == 0) {
+                    exam->first_claim_us = ExamStats::now_us();
+                }
+                return q;
+            }
+            
+            // Part B: claim under the question's semaphore, re-checking once held
+            if (!sem_manager->try_mark_question(q, current_slot)) {
+                continue;
+            }
+            bool claimed = claim_question(exam, q, ta_id);
+            if (claimed) {
+                duplicate_claim = RaceDetector::record_claim(races, exam, q);
+                
+                // Only the first claimer sees 0 and stamps it
+                uint64_t unset = 0;
+                __atomic_compare_exchange_n(&exam->first_claim_us, &unset, ExamStats::now_us(),
+                                            false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            }
+            sem_manager->finish_mark_question(q, current_slot);
+            
+            if (claimed) {
+                return q;
+            }
         }
     }
     
     return -1; // No questions available
 }
 
-void TAProcess::mark_question(int question_num, int student_number) {
+void TAProcess::mark_question(int question_num, int64_t student_number) {
     std::cout << "[TA " << ta_id << "] Marking question " << (question_num + 1) 
               << " for student " << student_number << std::endl;
     
-    // Simulate marking time (1.0 to 2.0 seconds)
-    double delay = get_random_delay(1.0, 2.0);
+    // Simulate marking time (1.0 to 2.0 seconds by default, or the traced time)
+    double delay = workload->mark_time(question_num, student_number, rng);
     usleep(delay * 1000000);
     
-    // Mark as complete
-    ExamData* exam = shared_mem->get_exam_data();
-    exam->questions_marked[question_num] = true;
-    exam->questions_being_marked[question_num] = -1;
+    // Mark as complete. Part B holds the slot's lock so a finished exam
+    // cannot be replaced by the next one before its latencies are recorded;
+    // other slots complete their questions meanwhile.
+    ExamData* exam = shared_mem->get_exam_data(current_slot);
+    ExamStatsData* stats = shared_mem->get_exam_stats();
+    if (sem_manager != nullptr) {
+        sem_manager->lock_exam_slot(current_slot);
+    }
     
-    std::cout << "[TA " << ta_id << "] Finished marking question " << (question_num + 1) 
-              << " for student " << student_number << std::endl;
+    exam->question_done_us[question_num] = ExamStats::now_us();
+    int64_t exam_index = exam->current_exam_index;
+    bool all_done = complete_question(exam, question_num);
+    uint64_t turnaround_us = exam->question_done_us[question_num] - exam->loaded_us;
+    bool breached = all_done && ExamStats::record_exam(stats, exam);
     
-    // Check if all questions are marked
-    bool all_done = true;
-    for (int i = 0; i < 5; i++) {
-        if (!exam->questions_marked[i]) {
-            all_done = false;
-            break;
-        }
+    if (sem_manager != nullptr) {
+        sem_manager->unlock_exam_slot(current_slot);
     }
     
+    if (duplicate_claim) {
+        RaceDetector::record_duplicate_mark(&stats->races, delay);
+    }
+    
+    MarkRecord rec;
+    rec.exam_index = exam_index;
+    rec.student_number = student_number;
+    rec.question = question_num;
+    rec.ta_id = ta_id;
+    rec.mark_ms = (uint32_t)(delay * 1000);
+    rec.reserved = 0;
+    results.record(rec, current_slot);
+    
+    std::cout << "[TA " << ta_id << "] Finished marking question " << (question_num + 1) 
+              << " for student " << student_number << std::endl;
+    
     if (all_done) {
-        exam->all_marked = true;
         std::cout << "[TA " << ta_id << "] All questions marked for student " 
-                  << student_number << std::endl;
+                  << student_number << " in " << turnaround_us / 1e6 << "s" << std::endl;
+    }
+    if (breached) {
+        std::cout << "[TA " << ta_id << "] Student " << student_number
+                  << " breached the " << stats->slo_us / 1e6 << "s turnaround SLO" << std::endl;
     }
 }
 
 bool TAProcess::load_next_exam() {
-    ExamData* exam = shared_mem->get_exam_data();
-    int next_index = exam->current_exam_index + 1;
+    if (exam_queue != nullptr) {
+        return load_next_queued_exam();
+    }
+    
+    if (sem_manager == nullptr) {
+        return load_next_listed_exam();
+    }
     
-    if (next_index >= exam_list.size()) {
+    sem_manager->lock_exam_load();
+    
+    // Another TA may have loaded the next exam while we waited for the lock
+    bool loaded = true;
+    if (shared_mem->get_exam_data()->all_marked) {
+        loaded = load_next_listed_exam();
+    }
+    
+    sem_manager->unlock_exam_load();
+    return loaded;
+}
+
+bool TAProcess::load_next_listed_exam() {
+    // With several active exams the next one follows the newest in any slot
+    int slots = shared_mem->get_exam_slot_count();
+    int next_index = 0;
+    for (int slot = 0; slot < slots; slot++) {
+        next_index = std::max(next_index, shared_mem->get_exam_data(slot)->current_exam_index + 1);
+    }
+    
+    if (next_index >= shared_mem->get_exam_count()) {
         std::cout << "[TA " << ta_id << "] No more exams to load" << std::endl;
         return false;
     }
     
-    int next_student = exam_list[next_index];
+    int64_t next_student = shared_mem->get_exam_entry(next_index)->student_number;
+    
+    // Slots are refilled until the list runs out, the termination exam only ends it
+    if (slots > 1 && FileManager::is_termination_exam(next_student)) {
+        std::cout << "[TA " << ta_id << "] No more exams to load" << std::endl;
+        return false;
+    }
     
     std::cout << "[TA " << ta_id << "] Loading next exam (student " << next_student << ")" << std::endl;
     
     // Race Condtion expected, multiple TAs might try to load same exam
-    if (!shared_mem->load_exam_from_file(next_student, next_index)) {
+    if (sem_manager != nullptr) {
+        sem_manager->lock_exam_slot(current_slot);
+    }
+    bool loaded = shared_mem->load_exam_from_file(next_student, next_index, current_slot);
+    if (sem_manager != nullptr) {
+        sem_manager->unlock_exam_slot(current_slot);
+    }
+    if (!loaded) {
         std::cerr << "[TA " << ta_id << "] Failed to load exam for student " << next_student << std::endl;
+        load_failed = true;
         return false;
     }
     
+    RaceDetector::record_load(&shared_mem->get_exam_stats()->races, next_index);
+    
     std::cout << "[TA " << ta_id << "] Loaded exam for student " << next_student << std::endl;
     return true;
 }
 
-void TAProcess::run() {
-    std::cout << "[TA " << ta_id << "] Starting work..." << std::endl;
+// Streaming and priority mode: take the most urgent queued exam, or wait for
+// the main process to queue one until a drain
+bool TAProcess::load_next_queued_exam() {
+    ExamData* exam = shared_mem->get_exam_data();
     
     while (true) {
-        ExamData* exam = shared_mem->get_exam_data();
+        sem_manager->lock_exam_load();
         
-        // Check if we've reached the termination exam
-        if (exam->student_number == 9999) {
-            std::cout << "[TA " << ta_id << "] Reached termination exam (9999), stopping" << std::endl;
-            break;
+        if (!exam->all_marked) {
+            sem_manager->unlock_exam_load();
+            return true;
         }
         
-        // If current exam is complete, try to load next one
-        if (exam->all_marked) {
-            // Small delay to let others see it's complete
-            usleep(100000); // 0.1 seconds
+        int64_t next_student;
+        int32_t priority;
+        if (exam_queue->pop(next_student, &priority)) {
+            sem_manager->lock_exam_slot();
+            bool loaded = shared_mem->load_exam_from_file(next_student, exam->current_exam_index + 1);
+            sem_manager->unlock_exam_slot();
+            sem_manager->unlock_exam_load();
             
-            if (!load_next_exam()) {
+            if (!loaded) {
+                std::cerr << "[TA " << ta_id << "] Failed to load exam for student " << next_student << std::endl;
+                load_failed = true;
+                return false;
+            }
+            std::cout << "[TA " << ta_id << "] Loaded exam for student " << next_student
+                      << " (priority " << priority << ")" << std::endl;
+            return true;
+        }
+        
+        bool draining = exam_queue->is_draining();
+        sem_manager->unlock_exam_load();
+        
+        if (draining) {
+            std::cout << "[TA " << ta_id << "] Exam queue drained" << std::endl;
+            return false;
+        }
+        usleep(200000); // 0.2 seconds
+    }
+}
+
+// Whether any question of a loaded exam is still free to claim
+static bool has_unclaimed_question(const ExamData* exam) {
+    if (exam->all_marked) {
+        return false;
+    }
+    for (int q = 0; q < 5; q++) {
+        if (!exam->questions_marked[q] && exam->questions_being_marked[q] == -1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Several active exams (Part B only): work on the home slot (TA id modulo the
+// slot count) and spill over to another slot only when the home one has
+// nothing left to claim. With nothing to claim anywhere, a drained slot is
+// refilled from the exam list; only the refill takes the exam-load lock.
+// Returns false once the list is used up.
+bool TAProcess::pick_exam_slot() {
+    int slots = shared_mem->get_exam_slot_count();
+    int home = ta_id % slots;
+    
+    while (true) {
+        for (int i = 0; i < slots; i++) {
+            int slot = (home + i) % slots;
+            if (has_unclaimed_question(shared_mem->get_exam_data(slot))) {
+                if (slot != home && slot != current_slot) {
+                    std::cout << "[TA " << ta_id << "] Exam slot " << home
+                              << " drained, helping with slot " << slot << std::endl;
+                }
+                current_slot = slot;
+                return true;
+            }
+        }
+        
+        int drained = -1;
+        for (int i = 0; i < slots && drained == -1; i++) {
+            int slot = (home + i) % slots;
+            if (shared_mem->get_exam_data(slot)->all_marked) {
+                drained = slot;
+            }
+        }
+        if (drained == -1) {
+            // Every remaining question is being marked by someone else
+            usleep(200000); // 0.2 seconds
+            continue;
+        }
+        
+        sem_manager->lock_exam_load();
+        
+        // Another TA may have refilled the slot while we waited for the lock
+        bool loaded = true;
+        if (shared_mem->get_exam_data(drained)->all_marked) {
+            current_slot = drained;
+            loaded = load_next_listed_exam();
+        }
+        
+        sem_manager->unlock_exam_load();
+        
+        if (!loaded) {
+            return false;
+        }
+    }
+}
+
+bool TAProcess::run() {
+    std::cout << "[TA " << ta_id << "] Starting work..." << std::endl;
+    results.open(ta_id);
+    ExamStats::mark_ta_ready(shared_mem->get_exam_stats());
+    
+    while (true) {
+        ExamData* exam = shared_mem->get_exam_data();
+        
+        // Several active exams: slots are picked and refilled by pick_exam_slot()
+        if (shared_mem->get_exam_slot_count() > 1) {
+            if (!pick_exam_slot()) {
                 break;
             }
-            
-            // Check again if it's the termination exam
-            if (exam->student_number == 9999) {
-                std::cout << "[TA " << ta_id << "] Loaded termination exam (9999), stopping" << std::endl;
+            exam = shared_mem->get_exam_data(current_slot);
+        } else {
+            // Check if we've reached the termination exam (queued modes run until drained)
+            if (exam_queue == nullptr && exam->is_termination) {
+                std::cout << "[TA " << ta_id << "] Reached termination exam (9999), stopping" << std::endl;
                 break;
             }
+            
+            // If current exam is complete, try to load next one
+            if (exam->all_marked) {
+                // Small delay to let others see it's complete
+                usleep(100000); // 0.1 seconds
+                
+                if (!load_next_exam()) {
+                    break;
+                }
+                
+                // Check again if it's the termination exam
+                if (exam_queue == nullptr && exam->is_termination) {
+                    std::cout << "[TA " << ta_id << "] Loaded termination exam (9999), stopping" << std::endl;
+                    break;
+                }
+            }
         }
         
         // Review and possibly correct rubric
@@ -175,5 +455,7 @@ void TAProcess::run() {
         }
     }
     
+    results.close();
     std::cout << "[TA " << ta_id << "] Finished all work" << std::endl;
+    return !load_failed;
 }
\ No newline at end of file
@@ -2,28 +2,57 @@
 #define TA_PROCESS_H
 
 #include "shared_memory.h"
+#include "results.h"
+#include <random>
 #include <string>
-#include <vector>
 
 class SemaphoreManager;
+class ExamQueue;
+class WorkloadProfile;
 
 class TAProcess {
 private:
     int ta_id;
     SharedMemory* shared_mem;
-    std::vector<int> exam_list;
     SemaphoreManager* sem_manager;
+    ExamQueue* exam_queue;      // Set in streaming and priority mode only
+    const WorkloadProfile* workload;  // Marking/review delays and correction rates
+    std::mt19937 rng;
+    ResultsLog results;         // This TA's part file of marked questions
+    bool duplicate_claim;       // Race detector: last claim was already held by another TA
+    int current_slot;           // Exam slot being worked on (always 0 with one active exam)
+    bool load_failed;           // An exam could not be read, the run is incomplete
     
     void review_and_correct_rubric();
     int select_question_to_mark();
-    void mark_question(int question_num, int student_number);
-    double get_random_delay(double min, double max);
+    void mark_question(int question_num, int64_t student_number);
     bool load_next_exam();
+    bool load_next_listed_exam();
+    bool load_next_queued_exam();
+    bool pick_exam_slot();
     
 public:
-    // Constructor for Part B with semaphores
-    TAProcess(int id, SharedMemory* shm, const std::vector<int>& exams, SemaphoreManager* sem);
-    void run();
+    // Constructor; sem is nullptr for Part A. The exam list is read from shared memory.
+    TAProcess(int id, SharedMemory* shm, SemaphoreManager* sem);
+    
+    // Take exams from the shared queue instead of the exam list
+    void set_exam_queue(ExamQueue* queue);
+    
+    // Replace the built-in uniform delays with a loaded profile
+    void set_workload(const WorkloadProfile* profile);
+    
+    // Mark until there is nothing left. Returns false if an exam could not be
+    // loaded; the TA stops at that point instead of skipping it.
+    bool run();
+    
+    // Marking steps on the shared structures, without locking, delays or
+    // output. Also used by the coroutine simulation engine.
+    static bool claim_question(ExamData* exam, int question_num, int ta_id);
+    static bool complete_question(ExamData* exam, int question_num);  // True for the call that marks the 5th
+    // overwrote (if given) is set when the line changed between reading it and
+    // writing the correction, i.e. the write loses another TA's update
+    static bool correct_rubric_line(RubricData* rubric, int question_num, char& from, char& to,
+                                    bool* overwrote = nullptr);
 };
 
 #endif
\ No newline at end of file
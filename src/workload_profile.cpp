@@ -0,0 +1,236 @@
+// workload_profile.cpp
+// Marking-time distributions and trace replay for TAs and the simulator
+
+#include "workload_profile.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+
+double DelayDistribution::sample(std::mt19937& rng) const {
+    switch (kind) {
+    case UNIFORM:
+        return std::uniform_real_distribution<double>(a, b)(rng);
+    case LOGNORMAL:
+        return std::lognormal_distribution<double>(std::log(a), b)(rng);
+    case EMPIRICAL: {
+        double pick = std::uniform_real_distribution<double>(0.0, cumulative.back())(rng);
+        size_t bin = 0;
+        while (bin + 1 < cumulative.size() && pick >= cumulative[bin]) {
+            bin++;
+        }
+        if (bin_low[bin] == bin_high[bin]) {
+            return bin_low[bin];
+        }
+        return std::uniform_real_distribution<double>(bin_low[bin], bin_high[bin])(rng);
+    }
+    case FIXED:
+    default:
+        return a;
+    }
+}
+
+std::string DelayDistribution::describe() const {
+    char text[64];
+    switch (kind) {
+    case UNIFORM:
+        snprintf(text, sizeof(text), "uniform %.3g-%.3gs", a, b);
+        break;
+    case LOGNORMAL:
+        snprintf(text, sizeof(text), "lognormal median %.3gs sigma %.3g", a, b);
+        break;
+    case EMPIRICAL:
+        snprintf(text, sizeof(text), "empirical %zu bins", cumulative.size());
+        break;
+    case FIXED:
+    default:
+        snprintf(text, sizeof(text), "fixed %.3gs", a);
+        break;
+    }
+    return text;
+}
+
+WorkloadProfile::WorkloadProfile() : source("built-in") {
+    for (int q = 0; q < 5; q++) {
+        mark[q].kind = DelayDistribution::UNIFORM;
+        mark[q].a = 1.0;
+        mark[q].b = 2.0;
+        review[q].kind = DelayDistribution::UNIFORM;
+        review[q].a = 0.5;
+        review[q].b = 1.0;
+        correction_probability[q] = 0.30;
+    }
+}
+
+bool WorkloadProfile::parse_distribution(std::istringstream& in, DelayDistribution& dist) {
+    std::string kind;
+    in >> kind;
+    dist.bin_low.clear();
+    dist.bin_high.clear();
+    dist.cumulative.clear();
+
+    if (kind == "fixed") {
+        dist.kind = DelayDistribution::FIXED;
+        return (bool)(in >> dist.a) && dist.a >= 0;
+    }
+    if (kind == "uniform") {
+        dist.kind = DelayDistribution::UNIFORM;
+        return (bool)(in >> dist.a >> dist.b) && dist.a >= 0 && dist.b >= dist.a;
+    }
+    if (kind == "lognormal") {
+        dist.kind = DelayDistribution::LOGNORMAL;
+        return (bool)(in >> dist.a >> dist.b) && dist.a > 0 && dist.b >= 0;
+    }
+    if (kind != "empirical") {
+        return false;
+    }
+
+    dist.kind = DelayDistribution::EMPIRICAL;
+    double total = 0;
+    std::string bin;
+    while (in >> bin) {
+        double low, high, weight;
+        if (sscanf(bin.c_str(), "%lf-%lf:%lf", &low, &high, &weight) != 3) {
+            if (sscanf(bin.c_str(), "%lf:%lf", &low, &weight) != 2) {
+                return false;
+            }
+            high = low;
+        }
+        if (low < 0 || high < low || weight <= 0) {
+            return false;
+        }
+        total += weight;
+        dist.bin_low.push_back(low);
+        dist.bin_high.push_back(high);
+        dist.cumulative.push_back(total);
+    }
+    return !dist.cumulative.empty();
+}
+
+bool WorkloadProfile::load_trace(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open trace file: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line)) {
+        line_num++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream in(line);
+        int64_t student;
+        int question;
+        double seconds;
+        if (!(in >> student >> question >> seconds) || question < 1 || question > 5 || seconds < 0) {
+            std::cerr << "Error: " << path << ":" << line_num << ": expected <student> <question 1-5> <seconds>" << std::endl;
+            return false;
+        }
+        trace[std::make_pair(student, question - 1)] = seconds;
+    }
+    return true;
+}
+
+bool WorkloadProfile::load(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open workload profile: " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line)) {
+        line_num++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) {
+            line.erase(hash);
+        }
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive)) {
+            continue;
+        }
+
+        if (directive == "trace") {
+            std::string trace_path;
+            if (!(in >> trace_path) || !load_trace(trace_path)) {
+                std::cerr << "Error: " << path << ":" << line_num << ": bad trace directive" << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        // Every other directive applies to one question or to all of them
+        std::string target;
+        in >> target;
+        int first = 0, last = 4;
+        if (target != "*") {
+            first = last = atoi(target.c_str()) - 1;
+            if (first < 0 || first > 4) {
+                std::cerr << "Error: " << path << ":" << line_num << ": question must be 1-5 or *" << std::endl;
+                return false;
+            }
+        }
+
+        bool ok = true;
+        if (directive == "mark" || directive == "review") {
+            DelayDistribution dist;
+            ok = parse_distribution(in, dist);
+            for (int q = first; ok && q <= last; q++) {
+                (directive == "mark" ? mark[q] : review[q]) = dist;
+            }
+        } else if (directive == "correction") {
+            double probability;
+            ok = (bool)(in >> probability) && probability >= 0 && probability <= 1;
+            for (int q = first; ok && q <= last; q++) {
+                correction_probability[q] = probability;
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << "Error: " << path << ":" << line_num << ": could not parse '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+
+    source = path;
+    return true;
+}
+
+double WorkloadProfile::mark_time(int question, int64_t student_number, std::mt19937& rng) const {
+    std::map<std::pair<int64_t, int>, double>::const_iterator it =
+        trace.find(std::make_pair(student_number, question));
+    if (it != trace.end()) {
+        return it->second;
+    }
+    return mark[question].sample(rng);
+}
+
+double WorkloadProfile::review_time(int question, std::mt19937& rng) const {
+    return review[question].sample(rng);
+}
+
+bool WorkloadProfile::needs_correction(int question, std::mt19937& rng) const {
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < correction_probability[question];
+}
+
+void WorkloadProfile::print_summary() const {
+    std::cout << "Workload profile: " << source;
+    if (!trace.empty()) {
+        std::cout << " (" << trace.size() << " traced marking times)";
+    }
+    std::cout << std::endl;
+    for (int q = 0; q < 5; q++) {
+        std::cout << "  Q" << (q + 1) << ": mark " << mark[q].describe()
+                  << ", review " << review[q].describe()
+                  << ", correction " << (int)(correction_probability[q] * 100 + 0.5) << "%" << std::endl;
+    }
+}
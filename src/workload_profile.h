@@ -0,0 +1,67 @@
+#ifndef WORKLOAD_PROFILE_H
+#define WORKLOAD_PROFILE_H
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A delay in seconds drawn from one of the supported distributions
+struct DelayDistribution {
+    enum Kind { FIXED, UNIFORM, LOGNORMAL, EMPIRICAL };
+
+    Kind kind;
+    double a;                       // FIXED value, UNIFORM min, LOGNORMAL median
+    double b;                       // UNIFORM max, LOGNORMAL sigma
+    std::vector<double> bin_low;    // EMPIRICAL bins, sampled uniformly inside
+    std::vector<double> bin_high;
+    std::vector<double> cumulative; // Running total of the bin weights
+
+    double sample(std::mt19937& rng) const;
+    std::string describe() const;
+};
+
+// Marking/review delays and correction rates for each question, plus an
+// optional trace of recorded marking times that takes precedence.
+//
+// Profile file, one directive per line ('#' starts a comment, '*' means all
+// five questions):
+//   mark <q|*> <distribution>
+//   review <q|*> <distribution>
+//   correction <q|*> <probability>
+//   trace <path>
+// Distributions:
+//   fixed <seconds>
+//   uniform <min> <max>
+//   lognormal <median> <sigma>
+//   empirical <low>-<high>:<weight> ...   (or <value>:<weight> for a point)
+// Trace file lines: <student_number> <question 1-5> <seconds>
+class WorkloadProfile {
+private:
+    DelayDistribution mark[5];
+    DelayDistribution review[5];
+    double correction_probability[5];
+    std::map<std::pair<int64_t, int>, double> trace;
+    std::string source;
+
+    static bool parse_distribution(std::istringstream& in, DelayDistribution& dist);
+    bool load_trace(const std::string& path);
+
+public:
+    // The built-in profile: 1-2 s marking, 0.5-1 s review, 30% corrections
+    WorkloadProfile();
+
+    bool load(const std::string& path);
+
+    // Question numbers are 0-4
+    double mark_time(int question, int64_t student_number, std::mt19937& rng) const;
+    double review_time(int question, std::mt19937& rng) const;
+    bool needs_correction(int question, std::mt19937& rng) const;
+
+    void print_summary() const;
+};
+
+#endif